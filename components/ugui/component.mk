@@ -6,3 +6,34 @@
 # in the build directory. This behaviour is entirely configurable,
 # please read the ESP-IDF documents if you need to do this.
 #
+
+# Only the fonts referenced from main/ are linked, trimmed to printable ASCII.
+# tools/mkfont is built for the host and writes the subset tables into the
+# component build directory; ugui.c drops its own tables under UGUI_FONT_SUBSET.
+# Glyphs are stored as bitmaps by default. -s stores them as per-row runs
+# (FONT_TYPE_SPAN), drawn as span fills: faster text, but about 3x the
+# font data for the current fonts (5946 vs 1900 bytes). Opt in with
+# "make MKFONT_ARGS=-s".
+MKFONT_SOURCES := $(wildcard $(PROJECT_PATH)/main/*.c)
+MKFONT_ARGS ?=
+
+# The subset covers printable ASCII plus any higher character codes found in
+# MKFONT_SOURCES. Text only known at run time (file names read from the SD
+# card) is not scanned: characters outside the range are skipped by
+# UG_PutString. Add e.g. -r FONT_8X12=0x20-0xff to MKFONT_ARGS to keep them.
+CFLAGS += -DUGUI_FONT_SUBSET
+
+COMPONENT_OBJS := ugui.o ugui_font_subset.o
+COMPONENT_EXTRA_CLEAN := mkfont ugui_font_subset.c
+
+mkfont: $(PROJECT_PATH)/tools/mkfont/main.c $(COMPONENT_PATH)/ugui.c $(COMPONENT_PATH)/ugui_config.h
+	$(summary) HOSTCC $@
+	$(HOSTCC) -O2 -I$(COMPONENT_PATH) $(PROJECT_PATH)/tools/mkfont/main.c $(COMPONENT_PATH)/ugui.c -o $@
+
+ugui_font_subset.c: mkfont $(MKFONT_SOURCES)
+	$(summary) MKFONT $@
+	./mkfont -o $@ $(MKFONT_ARGS) $(MKFONT_SOURCES)
+
+ugui_font_subset.o: ugui_font_subset.c
+	$(summary) CC $@
+	$(CC) $(CFLAGS) $(CPPFLAGS) $(addprefix -I ,$(COMPONENT_INCLUDES)) -I $(COMPONENT_PATH) -c $< -o $@
@@ -62,6 +62,9 @@
  /* Pointer to the gui */
 static UG_GUI* gui;
 
+/* Font tables are replaced by a generated subset (tools/mkfont) when */
+/* UGUI_FONT_SUBSET is defined.                                        */
+#ifndef UGUI_FONT_SUBSET
 #ifdef USE_FONT_4X6
 __UG_FONT_DATA unsigned char font_4x6[256][6]={
 {0x00,0x00,0x00,0x00,0x00,0x00}, // 0x00
@@ -4551,6 +4554,7 @@ __UG_FONT_DATA unsigned char font_32x53[256][212]={
 #ifdef USE_FONT_32X53
    const UG_FONT FONT_32X53 = {(unsigned char*)font_32x53,FONT_TYPE_1BPP,32,53,0,255,NULL};
 #endif
+#endif /* UGUI_FONT_SUBSET */
 
 
 
@@ -5367,6 +5371,31 @@ void _UG_PutChar( char chr, UG_S16 x, UG_S16 y, UG_COLOR fc, UG_COLOR bc, const
    if ( font->char_width % 8 ) bn++;
    actual_char_width = (font->widths ? font->widths[bt - font->start_char] : font->char_width);
 
+   /* Is a glyph renderer available? */
+   if ( gui->driver[DRIVER_PUT_CHAR].state & DRIVER_ENABLED )
+   {
+      if( ((UG_RESULT(*)(UG_U8 chr, UG_S16 x, UG_S16 y, UG_COLOR fc, UG_COLOR bc, const UG_FONT* font))gui->driver[DRIVER_PUT_CHAR].driver)(bt,x,y,fc,bc,font) == UG_RESULT_OK ) return;
+   }
+
+   /* Run-length font: one background fill plus a fill per foreground span */
+   if ( font->font_type == FONT_TYPE_SPAN )
+   {
+      const UG_SPAN_DATA* spans = (const UG_SPAN_DATA*)font->p;
+      const UG_U8* run = spans->runs + spans->offsets[bt - font->start_char];
+
+      UG_FillFrame(x,y,x+actual_char_width-1,y+font->char_height-1,bc);
+      for( j=0;j<font->char_height;j++ )
+      {
+         c = *run++;
+         while ( c-- )
+         {
+            UG_FillFrame(x+run[0],y+j,x+run[0]+run[1]-1,y+j,fc);
+            run += 2;
+         }
+      }
+      return;
+   }
+
    /* Is hardware acceleration available? */
    if ( gui->driver[DRIVER_FILL_AREA].state & DRIVER_ENABLED )
    {
@@ -27,7 +27,8 @@
 typedef enum
 {
 	FONT_TYPE_1BPP,
-	FONT_TYPE_8BPP
+	FONT_TYPE_8BPP,
+	FONT_TYPE_SPAN
 } FONT_TYPE;
 
 typedef struct
@@ -41,6 +42,15 @@ typedef struct
    UG_U8  *widths;
 } UG_FONT;
 
+/* Glyph data of a FONT_TYPE_SPAN font, generated by tools/mkfont. offsets[] */
+/* holds the start of each glyph in runs[]. Every glyph row is a run count    */
+/* followed by (x, length) pairs of foreground pixels.                        */
+typedef struct
+{
+   const UG_U16* offsets;
+   const UG_U8* runs;
+} UG_SPAN_DATA;
+
 #ifdef USE_FONT_4X6
    extern const UG_FONT FONT_4X6;
 #endif
@@ -548,10 +558,11 @@ typedef struct
 #define DRIVER_ENABLED                                (1<<1)
 
 /* Supported drivers */
-#define NUMBER_OF_DRIVERS                             3
+#define NUMBER_OF_DRIVERS                             4
 #define DRIVER_DRAW_LINE                              0
 #define DRIVER_FILL_FRAME                             1
 #define DRIVER_FILL_AREA                              2
+#define DRIVER_PUT_CHAR                               3
 
 /* -------------------------------------------------------------------------------- */
 /* -- µGUI CORE STRUCTURE                                                        -- */
@@ -1,19 +1,66 @@
 #include "input.h"
+#include "input_debounce.h"
+#include "input_snapshot.h"
 
 #include "driver/gpio.h"
 #include "driver/adc.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "nvs.h"
 
 
 static volatile bool input_task_is_running = false;
-static volatile odroid_gamepad_state gamepad_state;
+static odroid_gamepad_state gamepad_state;
 static odroid_gamepad_state previous_gamepad_state;
-static uint8_t debounce[ODROID_INPUT_MAX];
+static input_debounce_t debounce[ODROID_INPUT_MAX];
+static odroid_input_calibration calibration;
 static volatile bool input_gamepad_initialized = false;
-static SemaphoreHandle_t xSemaphore;
 
+// Published state (single writer: input_task)
+static input_snapshot_lock_t published;
+_Static_assert(ODROID_INPUT_MAX <= INPUT_SNAPSHOT_MAX_BUTTONS, "snapshot too small");
+_Static_assert(INPUT_DPAD_UP == 1 << ODROID_INPUT_UP && INPUT_DPAD_RIGHT == 1 << ODROID_INPUT_RIGHT &&
+    INPUT_DPAD_DOWN == 1 << ODROID_INPUT_DOWN && INPUT_DPAD_LEFT == 1 << ODROID_INPUT_LEFT,
+    "D-pad bits out of order");
+static QueueHandle_t event_queue;
+static TickType_t repeat_next_tick[ODROID_INPUT_MAX];
+static uint16_t repeat_count[ODROID_INPUT_MAX];
+static TaskHandle_t input_task_handle;
+
+#define EVENT_QUEUE_LENGTH (16)
+
+// Sampling period while any button is held or settling (debounce and
+// repeat timing), and while idle. The digital buttons wake the task by
+// interrupt; the analog D-pad can only be observed by sampling.
+// ACTIVE_POLL_MS is also the minimum spacing between samples, so an edge
+// wake in the middle of contact bounce does not feed the integrator a
+// burst of samples microseconds apart.
+#define ACTIVE_POLL_MS (10)
+#define IDLE_POLL_MS (50)
+
+// START (GPIO39) is left out: GPIO36/39 see spurious edges whenever ADC1
+// is powered, which the D-pad sampling keeps it. It is polled instead.
+static const gpio_num_t digital_buttons[] = {
+    ODROID_GAMEPAD_IO_SELECT,
+    ODROID_GAMEPAD_IO_A,
+    ODROID_GAMEPAD_IO_B,
+    ODROID_GAMEPAD_IO_MENU,
+    ODROID_GAMEPAD_IO_VOLUME
+};
+
+#define REPEAT_MASK ((1 << ODROID_INPUT_UP) | (1 << ODROID_INPUT_RIGHT) | \
+                     (1 << ODROID_INPUT_DOWN) | (1 << ODROID_INPUT_LEFT))
+
+#define CALIBRATION_NAMESPACE "input"
+#define CALIBRATION_KEY "dpad_cal"
+
+static const odroid_input_calibration default_calibration = {
+    .x = { .high = 2048 + 1024, .low = 1024 },
+    .y = { .high = 2048 + 1024, .low = 1024 }
+};
 
 
 
@@ -24,37 +71,11 @@ odroid_gamepad_state input_read_raw()
     int joyX = adc1_get_raw(ODROID_GAMEPAD_IO_X);
     int joyY = adc1_get_raw(ODROID_GAMEPAD_IO_Y);
 
-    if (joyX > 2048 + 1024)
-    {
-        state.values[ODROID_INPUT_LEFT] = 1;
-        state.values[ODROID_INPUT_RIGHT] = 0;
-    }
-    else if (joyX > 1024)
-    {
-        state.values[ODROID_INPUT_LEFT] = 0;
-        state.values[ODROID_INPUT_RIGHT] = 1;
-    }
-    else
-    {
-        state.values[ODROID_INPUT_LEFT] = 0;
-        state.values[ODROID_INPUT_RIGHT] = 0;
-    }
-
-    if (joyY > 2048 + 1024)
-    {
-        state.values[ODROID_INPUT_UP] = 1;
-        state.values[ODROID_INPUT_DOWN] = 0;
-    }
-    else if (joyY > 1024)
-    {
-        state.values[ODROID_INPUT_UP] = 0;
-        state.values[ODROID_INPUT_DOWN] = 1;
-    }
-    else
-    {
-        state.values[ODROID_INPUT_UP] = 0;
-        state.values[ODROID_INPUT_DOWN] = 0;
-    }
+    uint8_t dpad = input_dpad_classify(&calibration.x, &calibration.y, joyX, joyY);
+    state.values[ODROID_INPUT_UP] = (dpad & INPUT_DPAD_UP) != 0;
+    state.values[ODROID_INPUT_RIGHT] = (dpad & INPUT_DPAD_RIGHT) != 0;
+    state.values[ODROID_INPUT_DOWN] = (dpad & INPUT_DPAD_DOWN) != 0;
+    state.values[ODROID_INPUT_LEFT] = (dpad & INPUT_DPAD_LEFT) != 0;
 
     state.values[ODROID_INPUT_SELECT] = !(gpio_get_level(ODROID_GAMEPAD_IO_SELECT));
     state.values[ODROID_INPUT_START] = !(gpio_get_level(ODROID_GAMEPAD_IO_START));
@@ -68,72 +89,160 @@ odroid_gamepad_state input_read_raw()
     return state;
 }
 
+void input_read_snapshot(odroid_gamepad_snapshot* out_snapshot)
+{
+    if (!input_gamepad_initialized) abort();
+
+    input_snapshot_read(&published, out_snapshot);
+}
+
 void input_read(odroid_gamepad_state* out_state)
 {
     if (!input_gamepad_initialized) abort();
 
-    xSemaphoreTake(xSemaphore, portMAX_DELAY);
+    uint32_t buttons = input_snapshot_buttons(&published);
 
-    *out_state = gamepad_state;
+    for (int i = 0; i < ODROID_INPUT_MAX; ++i)
+    {
+        out_state->values[i] = (buttons >> i) & 1;
+    }
+}
 
-    xSemaphoreGive(xSemaphore);
+static void input_publish(const odroid_gamepad_state* state)
+{
+    uint32_t buttons = 0;
+    for (int i = 0; i < ODROID_INPUT_MAX; ++i)
+    {
+        if (state->values[i]) buttons |= (1 << i);
+    }
+
+    if (buttons == input_snapshot_buttons(&published)) return;
+
+    input_snapshot_publish(&published, buttons, esp_timer_get_time());
 }
 
-static void input_task(void *arg)
+bool input_event_get(odroid_input_event* out_event, int timeout_ms)
 {
-    input_task_is_running = true;
+    if (!input_gamepad_initialized) abort();
+
+    TickType_t ticks = (timeout_ms < 0) ? portMAX_DELAY : timeout_ms / portTICK_PERIOD_MS;
+    return xQueueReceive(event_queue, out_event, ticks) == pdTRUE;
+}
+
+void input_event_flush()
+{
+    if (!input_gamepad_initialized) abort();
+
+    xQueueReset(event_queue);
+}
+
+static void input_post_event(uint8_t type, uint8_t button, uint16_t count, const odroid_gamepad_state* state)
+{
+    odroid_input_event event;
+    event.type = type;
+    event.button = button;
+    event.repeat_count = count;
+    event.state = *state;
+
+    if (xQueueSend(event_queue, &event, 0) != pdTRUE)
+    {
+        printf("%s: event queue full, dropped event (type=%d, button=%d).\n", __func__, type, button);
+    }
+}
+
+static void input_generate_events(const odroid_gamepad_state* state)
+{
+    TickType_t now = xTaskGetTickCount();
 
-    // Initialize state
     for(int i = 0; i < ODROID_INPUT_MAX; ++i)
     {
-        debounce[i] = 0xff;
+        if (state->values[i] && !previous_gamepad_state.values[i])
+        {
+            input_post_event(ODROID_INPUT_EVENT_PRESS, i, 0, state);
+
+            repeat_count[i] = 0;
+            repeat_next_tick[i] = now + ODROID_INPUT_REPEAT_DELAY_MS / portTICK_PERIOD_MS;
+        }
+        else if (!state->values[i] && previous_gamepad_state.values[i])
+        {
+            input_post_event(ODROID_INPUT_EVENT_RELEASE, i, 0, state);
+        }
+        else if (state->values[i] && (REPEAT_MASK & (1 << i)) &&
+                 (int32_t)(now - repeat_next_tick[i]) >= 0)
+        {
+            // Only repeat once the consumer has caught up so a slow redraw
+            // does not leave a backlog that keeps scrolling after release.
+            if (uxQueueMessagesWaiting(event_queue) == 0)
+            {
+                ++repeat_count[i];
+                input_post_event(ODROID_INPUT_EVENT_REPEAT, i, repeat_count[i], state);
+            }
+
+            int interval = ODROID_INPUT_REPEAT_START_MS - repeat_count[i] * ODROID_INPUT_REPEAT_STEP_MS;
+            if (interval < ODROID_INPUT_REPEAT_MIN_MS) interval = ODROID_INPUT_REPEAT_MIN_MS;
+
+            repeat_next_tick[i] = now + interval / portTICK_PERIOD_MS;
+        }
     }
+}
+
+static void IRAM_ATTR input_gpio_isr(void* arg)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    vTaskNotifyGiveFromISR(input_task_handle, &xHigherPriorityTaskWoken);
+
+    if (xHigherPriorityTaskWoken)
+        portYIELD_FROM_ISR();
+}
 
+static void input_task(void *arg)
+{
+    input_task_is_running = true;
 
     while(input_task_is_running)
     {
-        // Shift current values
-        for(int i = 0; i < ODROID_INPUT_MAX; ++i)
-		{
-			debounce[i] <<= 1;
-		}
+        TickType_t last_sample = xTaskGetTickCount();
 
         // Read hardware
         odroid_gamepad_state state = input_read_raw();
 
         // Debounce
-        xSemaphoreTake(xSemaphore, portMAX_DELAY);
+        bool active = false;
 
         for(int i = 0; i < ODROID_INPUT_MAX; ++i)
 		{
-            debounce[i] |= state.values[i] ? 1 : 0;
-            uint8_t val = debounce[i] & 0x03; //0x0f;
-            switch (val) {
-                case 0x00:
-                    gamepad_state.values[i] = 0;
-                    break;
-
-                case 0x03: //0x0f:
-                    gamepad_state.values[i] = 1;
-                    break;
-
-                default:
-                    // ignore
-                    break;
+            input_debounce_update(&debounce[i], state.values[i]);
+            gamepad_state.values[i] = debounce[i].value;
+
+            if (state.values[i] || debounce[i].value || !input_debounce_is_settled(&debounce[i]))
+            {
+                active = true;
             }
 		}
 
+        input_publish(&gamepad_state);
+
+        input_generate_events(&gamepad_state);
         previous_gamepad_state = gamepad_state;
 
-        xSemaphoreGive(xSemaphore);
+        // Sleep until the next sample is due or a button edge interrupt fires
+        int delay_ms = active ? ACTIVE_POLL_MS : IDLE_POLL_MS;
+        ulTaskNotifyTake(pdTRUE, delay_ms / portTICK_PERIOD_MS);
+
+        // An edge wake may come right after the previous sample; returns at
+        // once if the minimum spacing has already passed.
+        vTaskDelayUntil(&last_sample, ACTIVE_POLL_MS / portTICK_PERIOD_MS);
+    }
 
-        // delay
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+    for (int i = 0; i < sizeof(digital_buttons) / sizeof(digital_buttons[0]); ++i)
+    {
+        gpio_isr_handler_remove(digital_buttons[i]);
     }
 
     input_gamepad_initialized = false;
 
-    vSemaphoreDelete(xSemaphore);
+    vQueueDelete(event_queue);
 
     // Remove the task from scheduler
     vTaskDelete(NULL);
@@ -142,13 +251,89 @@ static void input_task(void *arg)
     while (1) { vTaskDelay(1);}
 }
 
+void input_read_axes(int* out_x, int* out_y, int samples)
+{
+    if (samples < 1) samples = 1;
+
+    int x = 0;
+    int y = 0;
+    for (int i = 0; i < samples; ++i)
+    {
+        x += adc1_get_raw(ODROID_GAMEPAD_IO_X);
+        y += adc1_get_raw(ODROID_GAMEPAD_IO_Y);
+    }
+
+    *out_x = x / samples;
+    *out_y = y / samples;
+}
+
+esp_err_t input_calibration_set(const odroid_input_calibration* new_calibration)
+{
+    calibration = *new_calibration;
+
+    nvs_handle handle;
+    esp_err_t err = nvs_open(CALIBRATION_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK)
+    {
+        printf("%s: nvs_open failed (%d).\n", __func__, err);
+        return err;
+    }
+
+    err = nvs_set_blob(handle, CALIBRATION_KEY, &calibration, sizeof(calibration));
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(handle);
+    }
+
+    nvs_close(handle);
+
+    if (err != ESP_OK)
+    {
+        printf("%s: saving calibration failed (%d).\n", __func__, err);
+    }
+
+    return err;
+}
+
+static void input_calibration_load()
+{
+    calibration = default_calibration;
+
+    nvs_handle handle;
+    if (nvs_open(CALIBRATION_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) return;
+
+    odroid_input_calibration stored;
+    size_t length = sizeof(stored);
+    esp_err_t err = nvs_get_blob(handle, CALIBRATION_KEY, &stored, &length);
+
+    nvs_close(handle);
+
+    if (err == ESP_OK && length == sizeof(stored) &&
+        stored.x.high > stored.x.low && stored.x.low > 0 &&
+        stored.y.high > stored.y.low && stored.y.low > 0)
+    {
+        calibration = stored;
+        printf("%s: x=(%d, %d), y=(%d, %d)\n", __func__,
+            calibration.x.high, calibration.x.low, calibration.y.high, calibration.y.low);
+    }
+}
+
 void input_init()
 {
-    xSemaphore = xSemaphoreCreateMutex();
+    input_calibration_load();
 
-    if(xSemaphore == NULL)
+    for(int i = 0; i < ODROID_INPUT_MAX; ++i)
     {
-        printf("xSemaphoreCreateMutex failed.\n");
+        bool dpad = (REPEAT_MASK & (1 << i)) != 0;
+        input_debounce_init(&debounce[i], dpad ? INPUT_DEBOUNCE_DPAD_WINDOW : INPUT_DEBOUNCE_BUTTON_WINDOW, 0);
+    }
+
+    input_snapshot_init(&published);
+
+    event_queue = xQueueCreate(EVENT_QUEUE_LENGTH, sizeof(odroid_input_event));
+    if(event_queue == NULL)
+    {
+        printf("xQueueCreate failed.\n");
         abort();
     }
 
@@ -174,8 +359,22 @@ void input_init()
 
     input_gamepad_initialized = true;
 
-    // Start background polling
-    xTaskCreatePinnedToCore(&input_task, "input_task", 1024 * 2, NULL, 5, NULL, 1);
+    // Start background sampling
+    xTaskCreatePinnedToCore(&input_task, "input_task", 1024 * 2, NULL, 5, &input_task_handle, 1);
+
+    // Wake the task on any digital button edge
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE)
+    {
+        printf("gpio_install_isr_service failed (%d).\n", err);
+        abort();
+    }
+
+    for (int i = 0; i < sizeof(digital_buttons) / sizeof(digital_buttons[0]); ++i)
+    {
+        gpio_set_intr_type(digital_buttons[i], GPIO_INTR_ANYEDGE);
+        gpio_isr_handler_add(digital_buttons[i], input_gpio_isr, NULL);
+    }
 
   	printf("%s: done.\n", __func__);
 }
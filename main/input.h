@@ -1,6 +1,11 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "input_debounce.h"
+#include "input_snapshot.h"
 
 
 #define ODROID_GAMEPAD_IO_X ADC1_CHANNEL_6
@@ -34,7 +39,47 @@ typedef struct
     uint8_t values[ODROID_INPUT_MAX];
 } odroid_gamepad_state;
 
+typedef struct
+{
+    input_axis_thresholds_t x;
+    input_axis_thresholds_t y;
+} odroid_input_calibration;
+
+// buttons: bit n = ODROID_INPUT_n
+typedef input_snapshot_t odroid_gamepad_snapshot;
+
+
+enum
+{
+    ODROID_INPUT_EVENT_PRESS = 0,
+    ODROID_INPUT_EVENT_RELEASE,
+    ODROID_INPUT_EVENT_REPEAT
+};
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t button;
+    uint16_t repeat_count;
+    odroid_gamepad_state state;
+} odroid_input_event;
+
+
+// Hold-to-repeat timing (D-pad only). The interval shrinks by
+// ODROID_INPUT_REPEAT_STEP_MS per repeat down to ODROID_INPUT_REPEAT_MIN_MS.
+#define ODROID_INPUT_REPEAT_DELAY_MS (400)
+#define ODROID_INPUT_REPEAT_START_MS (150)
+#define ODROID_INPUT_REPEAT_MIN_MS (40)
+#define ODROID_INPUT_REPEAT_STEP_MS (10)
+
 
 void input_init();
 void input_read(odroid_gamepad_state* out_state);
+void input_read_snapshot(odroid_gamepad_snapshot* out_snapshot);
 odroid_gamepad_state input_read_raw();
+
+void input_read_axes(int* out_x, int* out_y, int samples);
+esp_err_t input_calibration_set(const odroid_input_calibration* new_calibration);
+
+bool input_event_get(odroid_input_event* out_event, int timeout_ms);
+void input_event_flush();
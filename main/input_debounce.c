@@ -0,0 +1,86 @@
+#include "input_debounce.h"
+
+
+// Minimum ADC distance between calibrated positions. Anything closer
+// cannot be told apart reliably and is rejected.
+#define AXIS_MIN_SEPARATION (256)
+
+
+void input_debounce_init(input_debounce_t* debounce, uint8_t window, uint8_t value)
+{
+    if (window < 1) window = 1;
+
+    debounce->window = window;
+    debounce->value = value ? 1 : 0;
+    debounce->count = value ? window : 0;
+}
+
+// Returns true when the debounced value changed.
+bool input_debounce_update(input_debounce_t* debounce, uint8_t raw)
+{
+    if (raw)
+    {
+        if (debounce->count < debounce->window) ++debounce->count;
+    }
+    else
+    {
+        if (debounce->count > 0) --debounce->count;
+    }
+
+    uint8_t previous = debounce->value;
+
+    if (debounce->count == 0)
+    {
+        debounce->value = 0;
+    }
+    else if (debounce->count == debounce->window)
+    {
+        debounce->value = 1;
+    }
+
+    return debounce->value != previous;
+}
+
+bool input_debounce_is_settled(const input_debounce_t* debounce)
+{
+    return debounce->count == (debounce->value ? debounce->window : 0);
+}
+
+int input_axis_classify(const input_axis_thresholds_t* thresholds, int raw)
+{
+    if (raw > thresholds->high)
+    {
+        return INPUT_AXIS_HIGH;
+    }
+    else if (raw > thresholds->low)
+    {
+        return INPUT_AXIS_LOW;
+    }
+    else
+    {
+        return INPUT_AXIS_NONE;
+    }
+}
+
+uint8_t input_dpad_classify(const input_axis_thresholds_t* x, const input_axis_thresholds_t* y,
+    int raw_x, int raw_y)
+{
+    static const uint8_t x_bits[] = { 0, INPUT_DPAD_LEFT, INPUT_DPAD_RIGHT };
+    static const uint8_t y_bits[] = { 0, INPUT_DPAD_UP, INPUT_DPAD_DOWN };
+
+    return x_bits[input_axis_classify(x, raw_x)] | y_bits[input_axis_classify(y, raw_y)];
+}
+
+// The resistor ladder reads lowest at rest, mid-scale for one direction
+// and full-scale for the other. Thresholds sit halfway between them.
+bool input_axis_thresholds_from_samples(input_axis_thresholds_t* out_thresholds,
+    int rest, int high_direction, int low_direction)
+{
+    if (low_direction - rest < AXIS_MIN_SEPARATION) return false;
+    if (high_direction - low_direction < AXIS_MIN_SEPARATION) return false;
+
+    out_thresholds->high = (high_direction + low_direction) / 2;
+    out_thresholds->low = (low_direction + rest) / 2;
+
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Hardware independent parts of the input pipeline: per-button
+// integrating debounce and analog D-pad classification. Kept free of
+// ESP-IDF dependencies so recorded sample traces can be replayed on a host.
+
+// Integration windows in samples, one sample per input task period. The
+// analog D-pad is noisier near its thresholds than the digital buttons are
+// when bouncing.
+#define INPUT_DEBOUNCE_DPAD_WINDOW (3)
+#define INPUT_DEBOUNCE_BUTTON_WINDOW (2)
+
+typedef struct
+{
+    uint8_t window; // consecutive-sample weight required to change state
+    uint8_t count;  // integrator, 0 .. window
+    uint8_t value;  // debounced state
+} input_debounce_t;
+
+typedef struct
+{
+    // raw > high: first direction (LEFT / UP)
+    // raw > low: second direction (RIGHT / DOWN)
+    // otherwise: released
+    int32_t high;
+    int32_t low;
+} input_axis_thresholds_t;
+
+enum
+{
+    INPUT_AXIS_NONE = 0,
+    INPUT_AXIS_HIGH,
+    INPUT_AXIS_LOW
+};
+
+// D-pad directions, bit n = ODROID_INPUT_n
+enum
+{
+    INPUT_DPAD_UP = 1 << 0,
+    INPUT_DPAD_RIGHT = 1 << 1,
+    INPUT_DPAD_DOWN = 1 << 2,
+    INPUT_DPAD_LEFT = 1 << 3
+};
+
+
+void input_debounce_init(input_debounce_t* debounce, uint8_t window, uint8_t value);
+bool input_debounce_update(input_debounce_t* debounce, uint8_t raw);
+bool input_debounce_is_settled(const input_debounce_t* debounce);
+
+int input_axis_classify(const input_axis_thresholds_t* thresholds, int raw);
+bool input_axis_thresholds_from_samples(input_axis_thresholds_t* out_thresholds,
+    int rest, int high_direction, int low_direction);
+
+// Directions held in one pair of axis readings
+uint8_t input_dpad_classify(const input_axis_thresholds_t* x, const input_axis_thresholds_t* y,
+    int raw_x, int raw_y);
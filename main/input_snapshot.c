@@ -0,0 +1,64 @@
+#include "input_snapshot.h"
+
+
+void input_snapshot_init(input_snapshot_lock_t* lock)
+{
+    lock->sequence = 0;
+    lock->buttons = 0;
+
+    for (int i = 0; i < INPUT_SNAPSHOT_MAX_BUTTONS; ++i)
+    {
+        lock->last_transition_us[i] = 0;
+    }
+}
+
+// Records the transition time of every changed bit. Only one thread may
+// publish.
+void input_snapshot_publish(input_snapshot_lock_t* lock, uint32_t buttons, int64_t now_us)
+{
+    uint32_t changed = buttons ^ lock->buttons;
+    if (!changed) return;
+
+    lock->sequence = lock->sequence + 1;
+    __sync_synchronize();
+
+    for (int i = 0; i < INPUT_SNAPSHOT_MAX_BUTTONS; ++i)
+    {
+        if (changed & (1 << i))
+        {
+            lock->last_transition_us[i] = now_us;
+        }
+    }
+    lock->buttons = buttons;
+
+    __sync_synchronize();
+    lock->sequence = lock->sequence + 1;
+}
+
+// Copies a consistent snapshot, retrying until the same even sequence is
+// observed before and after the copy.
+void input_snapshot_read(const input_snapshot_lock_t* lock, input_snapshot_t* out_snapshot)
+{
+    uint32_t sequence;
+    do
+    {
+        sequence = lock->sequence;
+        __sync_synchronize();
+
+        out_snapshot->buttons = lock->buttons;
+        for (int i = 0; i < INPUT_SNAPSHOT_MAX_BUTTONS; ++i)
+        {
+            out_snapshot->last_transition_us[i] = lock->last_transition_us[i];
+        }
+
+        __sync_synchronize();
+    } while ((sequence & 1) || sequence != lock->sequence);
+
+    out_snapshot->sequence = sequence;
+}
+
+// The button mask is a single word, so no retry loop is needed for it alone
+uint32_t input_snapshot_buttons(const input_snapshot_lock_t* lock)
+{
+    return lock->buttons;
+}
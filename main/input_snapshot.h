@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+// Single-writer sequence lock for the published gamepad state. The writer
+// (input_task) never blocks and readers never block the writer; a reader
+// that overlaps an update simply copies again. Kept free of ESP-IDF
+// dependencies so it can be stress tested on a host.
+
+#define INPUT_SNAPSHOT_MAX_BUTTONS (16)
+
+typedef struct
+{
+    uint32_t sequence;
+    uint32_t buttons; // bit n = button n
+    int64_t last_transition_us[INPUT_SNAPSHOT_MAX_BUTTONS];
+} input_snapshot_t;
+
+typedef struct
+{
+    // Odd while an update is in progress
+    volatile uint32_t sequence;
+    volatile uint32_t buttons;
+    volatile int64_t last_transition_us[INPUT_SNAPSHOT_MAX_BUTTONS];
+} input_snapshot_lock_t;
+
+
+void input_snapshot_init(input_snapshot_lock_t* lock);
+void input_snapshot_publish(input_snapshot_lock_t* lock, uint32_t buttons, int64_t now_us);
+void input_snapshot_read(const input_snapshot_lock_t* lock, input_snapshot_t* out_snapshot);
+uint32_t input_snapshot_buttons(const input_snapshot_lock_t* lock);
@@ -7,15 +7,24 @@
 #include "driver/gpio.h"
 #include "esp_partition.h"
 #include "esp_ota_ops.h"
+#include "esp_image_format.h"
 #include "esp_heap_caps.h"
 #include "esp_flash_data_types.h"
 #include "rom/crc.h"
+#include "esp_timer.h"
 
 #include <string.h>
 
 #include "odroid_sdcard.h"
+#include "odroid_readahead.h"
 #include "odroid_display.h"
 #include "input.h"
+#include "odroid_spi_bus.h"
+#include "odroid_startup.h"
+#include "partition_plan.h"
+#include "odroid_partition_table.h"
+#include "ui_fb.h"
+#include "ui_glyph_cache.h"
 
 #include "../components/ugui/ugui.h"
 
@@ -60,6 +69,12 @@ char* VERSION = NULL;
 #define TILE_WIDTH (86)
 #define TILE_HEIGHT (48)
 #define TILE_LENGTH (TILE_WIDTH * TILE_HEIGHT * 2)
+
+#define GLYPH_CACHE_BUDGET (16 * 1024)
+
+// Power on with no button held boots OTA_0 straight away. Hold any button
+// to get to the menu.
+#define FAST_BOOT_ENABLED (1)
 //uint8_t TileData[TILE_LENGTH];
 
 
@@ -73,26 +88,19 @@ void indicate_error()
     }
 }
 
-static void pset(UG_S16 x, UG_S16 y, UG_COLOR color)
-{
-    fb[y * 320 + x] = color;
-}
-
 static void ui_update_display()
 {
-    ili9341_write_frame_rectangleLE(0, 0, 320, 240, fb);
+    // Only push what was drawn since the last update
+    short left, top, width, height;
+    if (!ui_fb_dirty_get(&left, &top, &width, &height)) return;
+
+    ili9341_write_frame_rectangle_strideLE(left, top, width, height, 320, fb + top * 320 + left);
+    ui_fb_dirty_clear();
 }
 
 static void ui_draw_image(short x, short y, short width, short height, uint16_t* data)
 {
-    for (short i = 0 ; i < height; ++i)
-    {
-        for (short j = 0; j < width; ++j)
-        {
-            uint16_t pixel = data[i * width + j];
-            UG_DrawPixel(x + j, y + i, pixel);
-        }
-    }
+    ui_fb_draw_image(x, y, width, height, data);
 }
 
 // TODO: default bad image tile
@@ -101,9 +109,12 @@ void ui_firmware_image_get(const char* filename, uint16_t* outData)
     //printf("%s: filename='%s'\n", __func__, filename);
     const uint8_t DEFAULT_DATA = 0xff;
 
-    FILE* file = fopen(filename, "rb");
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+
+    FILE* file = odroid_sdcard_pool_open(filename);
     if (!file)
     {
+        odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
         memset(outData, DEFAULT_DATA, TILE_LENGTH);
         return;
     }
@@ -153,7 +164,9 @@ void ui_firmware_image_get(const char* filename, uint16_t* outData)
 
 ui_firmware_image_get_exit:
     free(header);
-    fclose(file);
+    odroid_sdcard_pool_release(file);
+
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
 }
 
 static void ClearScreen()
@@ -202,7 +215,7 @@ static void DisplayProgress(int percent)
     short left = (320 / 2) - (WIDTH / 2);
     short top = (240 / 2) - (HEIGHT / 2) + 16;
     UG_FillFrame(left - 1, top - 1, left + WIDTH + 1, top + HEIGHT + 1, C_WHITE);
-    UG_DrawFrame(left - 1, top - 1, left + WIDTH + 1, top + HEIGHT + 1, C_BLACK);
+    ui_fb_draw_frame(left - 1, top - 1, left + WIDTH + 1, top + HEIGHT + 1, C_BLACK);
 
     if (FILL_WIDTH > 0)
     {
@@ -274,28 +287,42 @@ void boot_application()
 #define PART_TYPE_APP 0x00
 #define PART_SUBTYPE_FACTORY 0x00
 
-static void print_partitions()
+#define FLASH_SIZE (16 * 1024 * 1024)
+
+// Where a partition's data comes from: the .fw file or utility.bin
+typedef struct
 {
-    const esp_partition_info_t* partition_data = (const esp_partition_info_t*)malloc(ESP_PARTITION_TABLE_MAX_LEN);
-    if (!partition_data) abort();
+    odroid_sdcard_file* file;
+    off_t data_offset;
+    uint32_t length;
+} firmware_part_source_t;
 
-    esp_err_t err;
+static const partition_table_t* current_partition_table()
+{
+    const partition_table_t* table = odroid_partition_table_get();
+    if (!table)
+    {
+        DisplayError("PARTITION TABLE ERROR");
+        indicate_error();
+    }
 
-    err = spi_flash_read(ESP_PARTITION_TABLE_OFFSET, (void*)partition_data, ESP_PARTITION_TABLE_MAX_LEN);
-    if (err != ESP_OK) abort();
+    return table;
+}
 
-    for (int i = 0; i < ESP_PARTITION_TABLE_MAX_ENTRIES; ++i)
+static void print_partitions()
+{
+    const partition_table_t* table = current_partition_table();
+
+    for (int i = 0; i < table->count; ++i)
     {
-        const esp_partition_info_t *part = &partition_data[i];
-        if (part->magic == 0xffff) break;
+        const partition_table_entry_t* part = &table->entries[i];
 
-        printf("part %d:\n", i);
+        printf("part %d:\n", part->index);
 
 
-        printf("\tmagic=%#06x\n", part->magic);
         printf("\ttype=%#04x\n", part->type);
         printf("\tsubtype=%#04x\n", part->subtype);
-        printf("\t[pos.offset=%#010x, pos.size=%#010x]\n", part->pos.offset, part->pos.size);
+        printf("\t[pos.offset=%#010x, pos.size=%#010x]\n", part->offset, part->size);
         printf("\tlabel='%-16s'\n", part->label);
         printf("\tflags=%#010x\n", part->flags);
         printf("\n");
@@ -303,53 +330,71 @@ static void print_partitions()
 
 }
 
-static void write_partition_table(odroid_partition_t* parts, size_t parts_count)
+static bool partition_tables_equal(const esp_partition_info_t* a, const esp_partition_info_t* b)
+{
+    for (int i = 0; i < ESP_PARTITION_TABLE_MAX_ENTRIES; ++i)
+    {
+        bool aEnd = (a[i].magic != ESP_PARTITION_MAGIC);
+        bool bEnd = (b[i].magic != ESP_PARTITION_MAGIC);
+
+        if (aEnd || bEnd) return aEnd && bEnd;
+        if (memcmp(&a[i], &b[i], sizeof(esp_partition_info_t)) != 0) return false;
+    }
+
+    return true;
+}
+
+// Existing partitions at or above 'start', for the layout planner
+static int read_current_partitions(size_t start, partition_plan_entry_t* out, int max)
+{
+    const partition_table_t* table = current_partition_table();
+
+    int count = 0;
+    for (int i = 0; i < table->count && count < max; ++i)
+    {
+        const partition_table_entry_t* part = &table->entries[i];
+        if (part->offset < start) continue;
+
+        partition_plan_entry_t* entry = &out[count++];
+        entry->type = part->type;
+        entry->subtype = part->subtype;
+        memcpy(entry->label, part->label, PARTITION_PLAN_LABEL_LENGTH);
+        entry->offset = part->offset;
+        entry->size = part->size;
+    }
+
+    return count;
+}
+
+static void write_partition_table(const odroid_partition_t* parts, const partition_plan_entry_t* plan, size_t parts_count)
 {
     esp_err_t err;
 
 
-    // Read table
-    const esp_partition_info_t* partition_data = (const esp_partition_info_t*)malloc(ESP_PARTITION_TABLE_MAX_LEN);
+    // Start from the current table
+    const partition_table_t* table = current_partition_table();
+
+    esp_partition_info_t* partition_data = (esp_partition_info_t*)malloc(ESP_PARTITION_TABLE_MAX_LEN);
     if (!partition_data)
     {
         DisplayError("TABLE MEMORY ERROR");
         indicate_error();
     }
 
-    err = spi_flash_read(ESP_PARTITION_TABLE_OFFSET, (void*)partition_data, ESP_PARTITION_TABLE_MAX_LEN);
-    if (err != ESP_OK)
-    {
-        DisplayError("TABLE READ ERROR");
-        indicate_error();
-    }
+    memcpy(partition_data, table->raw, ESP_PARTITION_TABLE_MAX_LEN);
 
     // Find end of first partitioned
-    int startTableEntry = -1;
-    size_t startFlashAddress = 0xffffffff;
-
-    for (int i = 0; i < ESP_PARTITION_TABLE_MAX_ENTRIES; ++i)
-    {
-        const esp_partition_info_t *part = &partition_data[i];
-        if (part->magic == 0xffff) break;
-
-        if (part->magic == ESP_PARTITION_MAGIC)
-        {
-            if (part->type == PART_TYPE_APP &&
-                part->subtype == PART_SUBTYPE_FACTORY)
-            {
-                startTableEntry = i + 1;
-                startFlashAddress = part->pos.offset + part->pos.size;
-                break;
-            }
-        }
-    }
-
-    if (startTableEntry < 0)
+    const partition_table_entry_t* factory = partition_table_find(table,
+        PART_TYPE_APP, PART_SUBTYPE_FACTORY, NULL);
+    if (!factory)
     {
         DisplayError("NO FACTORY PARTITION ERROR");
         indicate_error();
     }
 
+    int startTableEntry = factory->index + 1;
+    size_t startFlashAddress = factory->offset + factory->size;
+
     printf("%s: startTableEntry=%d, startFlashAddress=%#08x\n",
         __func__, startTableEntry, startFlashAddress);
 
@@ -359,26 +404,35 @@ static void write_partition_table(odroid_partition_t* parts, size_t parts_count)
         memset(&partition_data[i], 0xff, sizeof(esp_partition_info_t));
     }
 
-    // Add partitions
-    size_t offset = 0;
+    // Add partitions at their planned offsets
+    if (startTableEntry + parts_count >= ESP_PARTITION_TABLE_MAX_ENTRIES)
+    {
+        DisplayError("TABLE SIZE ERROR");
+        indicate_error();
+    }
+
     for (int i = 0; i < parts_count; ++i)
     {
         esp_partition_info_t* part = &partition_data[startTableEntry + i];
         part->magic = ESP_PARTITION_MAGIC;
         part->type = parts[i].type;
         part->subtype = parts[i].subtype;
-        part->pos.offset = startFlashAddress + offset;
+        part->pos.offset = plan[i].offset;
         part->pos.size = parts[i].length;
         for (int j = 0; j < 16; ++j)
         {
             part->label[j] = parts[i].label[j];
         }
         part->flags = parts[i].flags;
-
-        offset += parts[i].length;
     }
 
-    //abort();
+    // An unchanged layout leaves the table sector alone
+    if (partition_tables_equal(partition_data, (const esp_partition_info_t*)table->raw))
+    {
+        printf("%s: partition table unchanged, not written.\n", __func__);
+        free(partition_data);
+        return;
+    }
 
     // Erase partition table
     if (ESP_PARTITION_TABLE_MAX_LEN > 4096)
@@ -402,6 +456,9 @@ static void write_partition_table(odroid_partition_t* parts, size_t parts_count)
         indicate_error();
     }
 
+    free(partition_data);
+
+    odroid_partition_table_invalidate();
     esp_partition_reload_table();
 }
 
@@ -410,6 +467,48 @@ static void ui_draw_title();
 
 //uint8_t tileData[TILE_LENGTH];
 
+// Progress is redrawn between SD read bursts at most this often. A full
+// frame push takes longer than reading and flashing a 4 KB block.
+#define PROGRESS_UPDATE_INTERVAL_US (250 * 1000)
+
+// Firmware data is read from the card in blocks of this size and then
+// flashed one 4 KB erase block at a time. Up to FIRMWARE_READ_AHEAD_BLOCKS
+// are read ahead while the previous block is checksummed or flashed.
+#define FIRMWARE_READ_BLOCK_SIZE (32 * 1024)
+#define FIRMWARE_READ_AHEAD_BLOCKS (3)
+
+#if FIRMWARE_READ_BLOCK_SIZE < ODROID_SDCARD_BLOCK_SIZE_MIN || FIRMWARE_READ_BLOCK_SIZE > ODROID_SDCARD_BLOCK_SIZE_MAX
+#error FIRMWARE_READ_BLOCK_SIZE out of range
+#endif
+
+static size_t sdcard_read(void* ptr, size_t size, odroid_sdcard_file* file)
+{
+    ssize_t count = odroid_sdcard_file_read(file, ptr, size);
+    return (count < 0) ? 0 : count;
+}
+
+static odroid_readahead* firmware_stream_start(odroid_sdcard_file* file, off_t offset, size_t length)
+{
+    odroid_readahead* stream = odroid_readahead_start(file, offset, length,
+        FIRMWARE_READ_BLOCK_SIZE, FIRMWARE_READ_AHEAD_BLOCKS);
+    if (!stream)
+    {
+        DisplayError("READ AHEAD ERROR");
+        indicate_error();
+    }
+
+    return stream;
+}
+
+static bool progress_update_due(int64_t* lastUpdate, bool force)
+{
+    int64_t now = esp_timer_get_time();
+    if (!force && now - *lastUpdate < PROGRESS_UPDATE_INTERVAL_US) return false;
+
+    *lastUpdate = now;
+    return true;
+}
+
 void flash_firmware(const char* fullPath)
 {
     size_t count;
@@ -422,8 +521,8 @@ void flash_firmware(const char* fullPath)
 
     printf("Opening file '%s'.\n", fullPath);
 
-    FILE* file = fopen(fullPath, "rb");
-    if (file == NULL)
+    odroid_sdcard_file* file = odroid_sdcard_file_open(fullPath);
+    if (!file)
     {
         DisplayError("FILE OPEN ERROR");
         indicate_error();
@@ -441,7 +540,7 @@ void flash_firmware(const char* fullPath)
     // null terminate
     memset(header, 0, headerLength + 1);
 
-    count = fread(header, 1, headerLength, file);
+    count = sdcard_read(header, headerLength, file);
     if (count != headerLength)
     {
         DisplayError("HEADER READ ERROR");
@@ -458,7 +557,7 @@ void flash_firmware(const char* fullPath)
     free(header);
 
     // read description
-    count = fread(FirmwareDescription, 1, FIRMWARE_DESCRIPTION_SIZE, file);
+    count = sdcard_read(FirmwareDescription, FIRMWARE_DESCRIPTION_SIZE, file);
     if (count != FIRMWARE_DESCRIPTION_SIZE)
     {
         DisplayError("DESCRIPTION READ ERROR");
@@ -480,7 +579,7 @@ void flash_firmware(const char* fullPath)
         indicate_error();
     }
 
-    count = fread(tileData, 1, TILE_LENGTH, file);
+    count = sdcard_read(tileData, TILE_LENGTH, file);
     if (count != TILE_LENGTH)
     {
         DisplayError("TILE READ ERROR");
@@ -495,7 +594,7 @@ void flash_firmware(const char* fullPath)
     free(tileData);
 
     // Tile border
-    UG_DrawFrame(tileLeft - 1, tileTop - 1, tileLeft + TILE_WIDTH, tileTop + TILE_HEIGHT, C_BLACK);
+    ui_fb_draw_frame(tileLeft - 1, tileTop - 1, tileLeft + TILE_WIDTH, tileTop + TILE_HEIGHT, C_BLACK);
     UpdateDisplay();
 
     // start to begin, b back
@@ -503,24 +602,23 @@ void flash_firmware(const char* fullPath)
     DisplayFooter("[B] Cancel");
     //UpdateDisplay();
 
-    odroid_gamepad_state previousState;
-    input_read(&previousState);
+    input_event_flush();
     while (true)
     {
-        odroid_gamepad_state state;
-        input_read(&state);
+        odroid_input_event event;
+        input_event_get(&event, -1);
+
+        if (event.type != ODROID_INPUT_EVENT_PRESS) continue;
 
-        if(!previousState.values[ODROID_INPUT_START] && state.values[ODROID_INPUT_START])
+        if (event.button == ODROID_INPUT_START)
         {
             break;
         }
-        else if(!previousState.values[ODROID_INPUT_B] && state.values[ODROID_INPUT_B])
+        else if (event.button == ODROID_INPUT_B)
         {
-            fclose(file);
+            odroid_sdcard_file_close(file);
             return;
         }
-
-        vTaskDelay(100 / portTICK_PERIOD_MS);
     }
 
     DisplayMessage("");
@@ -532,8 +630,8 @@ void flash_firmware(const char* fullPath)
 
 
     const int ERASE_BLOCK_SIZE = 4096;
-    void* data = malloc(ERASE_BLOCK_SIZE);
-    if (!data)
+    void* verify = malloc(ERASE_BLOCK_SIZE);
+    if (!verify)
     {
         DisplayError("DATA MEMORY ERROR");
         indicate_error();
@@ -541,16 +639,15 @@ void flash_firmware(const char* fullPath)
 
 
     // Verify file integerity
-    size_t current_position = ftell(file);
+    off_t current_position = odroid_sdcard_file_seek(file, 0, SEEK_CUR);
 
 
-    fseek(file, 0, SEEK_END);
-    size_t file_size = ftell(file);
+    size_t file_size = odroid_sdcard_file_seek(file, 0, SEEK_END);
 
 
     uint32_t expected_checksum;
-    fseek(file, file_size - sizeof(expected_checksum), SEEK_SET);
-    count = fread(&expected_checksum, 1, sizeof(expected_checksum), file);
+    odroid_sdcard_file_seek(file, file_size - sizeof(expected_checksum), SEEK_SET);
+    count = sdcard_read(&expected_checksum, sizeof(expected_checksum), file);
     if (count != sizeof(expected_checksum))
     {
         DisplayError("CHECKSUM READ ERROR");
@@ -559,24 +656,31 @@ void flash_firmware(const char* fullPath)
     printf("%s: expected_checksum=%#010x\n", __func__, expected_checksum);
 
 
-    fseek(file, 0, SEEK_SET);
-
     uint32_t checksum = 0;
     size_t check_offset = 0;
-    while(true)
+    const size_t check_length = file_size - sizeof(expected_checksum);
+
+    odroid_readahead* stream = firmware_stream_start(file, 0, check_length);
+    while (true)
     {
-        count = fread(data, 1, ERASE_BLOCK_SIZE, file);
-        if (check_offset + count == file_size)
-        {
-            count -= 4;
-        }
+        size_t block;
+        const void* data = odroid_readahead_borrow(stream, &block);
+        if (!data) break;
+
+        checksum = crc32_le(checksum, data, block);
+        check_offset += block;
 
-        checksum = crc32_le(checksum, data, count);
-        check_offset += count;
+        odroid_readahead_return(stream, data);
+    }
 
-        if (count < ERASE_BLOCK_SIZE) break;
+    if (odroid_readahead_failed(stream) || check_offset != check_length)
+    {
+        DisplayError("DATA READ ERROR");
+        indicate_error();
     }
 
+    odroid_readahead_stop(stream);
+
     printf("%s: checksum=%#010x\n", __func__, checksum);
 
     if (checksum != expected_checksum)
@@ -586,48 +690,52 @@ void flash_firmware(const char* fullPath)
     }
 
     // restore location to end of description
-    fseek(file, current_position, SEEK_SET);
+    odroid_sdcard_file_seek(file, current_position, SEEK_SET);
 
     //while(1) vTaskDelay(1);
 
 
     // Determine start address from end of 'factory' partition
-    const esp_partition_t* factory_part = esp_partition_find_first(ESP_PARTITION_TYPE_APP,
-            ESP_PARTITION_SUBTYPE_APP_FACTORY, NULL);
+    const partition_table_entry_t* factory_part = partition_table_find(current_partition_table(),
+            PART_TYPE_APP, PART_SUBTYPE_FACTORY, NULL);
     if (factory_part == NULL)
     {
-         printf("esp_partition_find_first failed. (FACTORY)\n");
+         printf("partition_table_find failed. (FACTORY)\n");
 
          DisplayError("FACTORY PARTITION ERROR");
          indicate_error();
     }
 
-    const size_t FLASH_START_ADDRESS = factory_part->address + factory_part->size;
-    printf("%s: FLASH_START_ADDRESS=%#010x\n", __func__, FLASH_START_ADDRESS);
+    const size_t FLASH_START_ADDRESS = factory_part->offset + factory_part->size;
+    printf("%s: FLASH_START_ADDRESS=%#010x, largest free gap=%#010x\n", __func__, FLASH_START_ADDRESS,
+        partition_table_largest_gap(current_partition_table(), FLASH_START_ADDRESS, FLASH_SIZE, PARTITION_PLAN_ALIGN));
 
 
     const size_t PARTS_MAX = 20;
     int parts_count = 0;
     odroid_partition_t* parts = malloc(sizeof(odroid_partition_t) * PARTS_MAX);
-    if (!parts)
+    firmware_part_source_t* sources = malloc(sizeof(firmware_part_source_t) * PARTS_MAX);
+    partition_plan_entry_t* plan = malloc(sizeof(partition_plan_entry_t) * PARTS_MAX);
+    bool* kept = malloc(sizeof(bool) * PARTS_MAX);
+    partition_plan_entry_t* current = malloc(sizeof(partition_plan_entry_t) * ESP_PARTITION_TABLE_MAX_ENTRIES);
+    if (!parts || !sources || !plan || !kept || !current)
     {
         DisplayError("PARTITION MEMORY ERROR");
         indicate_error();
     }
 
-    // Copy the firmware
-    size_t curren_flash_address = FLASH_START_ADDRESS;
-
+    // Collect the partitions first so the layout can be planned before
+    // anything is erased.
     while(true)
     {
-        if (ftell(file) >= (file_size - sizeof(checksum)))
+        if (odroid_sdcard_file_seek(file, 0, SEEK_CUR) >= (file_size - sizeof(checksum)))
         {
             break;
         }
 
         // Partition
         odroid_partition_t slot;
-        count = fread(&slot, 1, sizeof(slot), file);
+        count = sdcard_read(&slot, sizeof(slot), file);
         if (count != sizeof(slot))
         {
             DisplayError("PARTITION READ ERROR");
@@ -646,22 +754,10 @@ void flash_firmware(const char* fullPath)
             indicate_error();
         }
 
-        if (curren_flash_address + slot.length > 16 * 1024 * 1024)
-        {
-            DisplayError("PARTITION LENGTH ERROR");
-            indicate_error();
-        }
-
-        if ((curren_flash_address & 0xffff0000) != curren_flash_address)
-        {
-            DisplayError("PARTITION LENGTH ALIGNMENT ERROR");
-            indicate_error();
-        }
-
 
         // Data Length
         uint32_t length;
-        count = fread(&length, 1, sizeof(length), file);
+        count = sdcard_read(&length, sizeof(length), file);
         if (count != sizeof(length))
         {
             DisplayError("LENGTH READ ERROR");
@@ -677,9 +773,102 @@ void flash_firmware(const char* fullPath)
             indicate_error();
         }
 
-        size_t nextEntry = ftell(file) + length;
+        sources[parts_count].file = file;
+        sources[parts_count].data_offset = odroid_sdcard_file_seek(file, 0, SEEK_CUR);
+        sources[parts_count].length = length;
+        parts[parts_count++] = slot;
+
+        // Seek to next entry
+        if (odroid_sdcard_file_seek(file, length, SEEK_CUR) < 0)
+        {
+            DisplayError("SEEK ERROR");
+            indicate_error();
+        }
+    }
+
+
+    // Utility
+    odroid_sdcard_file* util = odroid_sdcard_file_open("/sd/odroid/firmware/utility.bin");
+    if (util)
+    {
+        if (parts_count >= PARTS_MAX)
+        {
+            DisplayError("PARTITION COUNT ERROR");
+            indicate_error();
+        }
+
+        // Get file size
+        size_t length = odroid_sdcard_file_seek(util, 0, SEEK_END);
+
+        printf("utility.bin - length=%d\n", length);
+
+        // Add partition
+        odroid_partition_t util_part;
+        memset(&util_part, 0, sizeof(util_part));
+
+
+        util_part.type = PART_TYPE_APP;
+        util_part.subtype = PART_SUBTYPE_TEST;
+
+        strcpy((char*)util_part.label, "utility");
+
+        util_part.flags = 0;
+
+        // 64k align
+        util_part.length = (length + 0xffff) & 0xffff0000;
+
+        sources[parts_count].file = util;
+        sources[parts_count].data_offset = 0;
+        sources[parts_count].length = length;
+        parts[parts_count++] = util_part;
+    }
+
 
-        if (length > 0)
+    // Plan the layout against the current table
+    for (int i = 0; i < parts_count; ++i)
+    {
+        memset(&plan[i], 0, sizeof(plan[i]));
+        plan[i].type = parts[i].type;
+        plan[i].subtype = parts[i].subtype;
+        memcpy(plan[i].label, parts[i].label, PARTITION_PLAN_LABEL_LENGTH);
+        plan[i].size = parts[i].length;
+    }
+
+    int current_count = read_current_partitions(FLASH_START_ADDRESS, current, ESP_PARTITION_TABLE_MAX_ENTRIES);
+
+    int kept_count = partition_plan_layout(current, current_count, plan, kept, parts_count,
+        FLASH_START_ADDRESS, FLASH_SIZE);
+    if (kept_count < 0)
+    {
+        DisplayError("PARTITION LENGTH ERROR");
+        indicate_error();
+    }
+
+    printf("%s: %d of %d partitions keep their offsets.\n", __func__, kept_count, parts_count);
+
+
+    // Copy the firmware
+    for (int part = 0; part < parts_count; ++part)
+    {
+        const firmware_part_source_t* source = &sources[part];
+        const size_t curren_flash_address = plan[part].offset;
+        const uint32_t length = source->length;
+        const bool isUtility = (source->file == util);
+
+        printf("%s: part %d '%.16s' at %#08x%s\n", __func__, part,
+            (const char*)parts[part].label, curren_flash_address, kept[part] ? " (kept)" : "");
+
+        if (length == 0) continue;
+
+        // Reading starts before the erase below so the two overlap
+        stream = firmware_stream_start(source->file, source->data_offset, length);
+
+        esp_err_t ret;
+
+        // A partition that stays in place is compared sector by sector and
+        // only differing sectors are erased and written. Anything else is
+        // erased up front.
+        if (!kept[part])
         {
             // turn LED off
             gpio_set_level(GPIO_NUM_2, 0);
@@ -690,13 +879,20 @@ void flash_firmware(const char* fullPath)
             if (eraseBlocks * ERASE_BLOCK_SIZE < length) ++eraseBlocks;
 
             // Display
-            sprintf(tempstring, "Erasing ... (%d)", parts_count);
+            if (isUtility)
+            {
+                sprintf(tempstring, "Erasing Utility ...");
+            }
+            else
+            {
+                sprintf(tempstring, "Erasing ... (%d)", part);
+            }
 
             printf("%s\n", tempstring);
             DisplayProgress(0);
             DisplayMessage(tempstring);
 
-            esp_err_t ret = spi_flash_erase_range(curren_flash_address, eraseBlocks * ERASE_BLOCK_SIZE);
+            ret = spi_flash_erase_range(curren_flash_address, eraseBlocks * ERASE_BLOCK_SIZE);
             if (ret != ESP_OK)
             {
                 printf("spi_flash_erase_range failed. eraseBlocks=%d\n", eraseBlocks);
@@ -707,202 +903,156 @@ void flash_firmware(const char* fullPath)
 
             // turn LED on
             gpio_set_level(GPIO_NUM_2, 1);
+        }
+
 
+        // Write data
+        int totalCount = 0;
+        int skippedBlocks = 0;
+        int64_t lastProgressUpdate = 0;
+        int block_offset = 0;
+        while (true)
+        {
+            // read
+            size_t block;
+            const void* data = odroid_readahead_borrow(stream, &block);
+            if (!data) break;
 
-            // Write data
-            int totalCount = 0;
-            for (int offset = 0; offset < length; offset += ERASE_BLOCK_SIZE)
+            const int sectorCount = (block + ERASE_BLOCK_SIZE - 1) / ERASE_BLOCK_SIZE;
+            partition_plan_range_t ranges[sectorCount];
+            int rangeCount;
+
+            if (kept[part])
             {
-                // Display
-                sprintf(tempstring, "Writing (%d)", parts_count);
+                // Only sectors that differ are rewritten, erased in as few
+                // ranges as possible
+                bool differs[sectorCount];
+                for (int i = 0; i < sectorCount; ++i)
+                {
+                    int offset = block_offset + i * ERASE_BLOCK_SIZE;
+                    count = length - offset;
+                    if (count > ERASE_BLOCK_SIZE) count = ERASE_BLOCK_SIZE;
 
-                printf("%s - %#08x\n", tempstring, offset);
-                DisplayProgress((float)offset / (float)(length - ERASE_BLOCK_SIZE) * 100.0f);
-                DisplayMessage(tempstring);
+                    ret = spi_flash_read(curren_flash_address + offset, verify, count);
+                    differs[i] = (ret != ESP_OK ||
+                        memcmp((const uint8_t*)data + i * ERASE_BLOCK_SIZE, verify, count) != 0);
+                }
 
-                // read
-                //printf("Reading offset=0x%x\n", offset);
-                count = fread(data, 1, ERASE_BLOCK_SIZE, file);
-                if (count <= 0)
+                rangeCount = partition_plan_erase_ranges(differs, sectorCount, ranges);
+                for (int r = 0; r < rangeCount; ++r)
                 {
-                    DisplayError("DATA READ ERROR");
-                    indicate_error();
+                    int offset = block_offset + ranges[r].first * ERASE_BLOCK_SIZE;
+                    ret = spi_flash_erase_range(curren_flash_address + offset, ranges[r].count * ERASE_BLOCK_SIZE);
+                    if (ret != ESP_OK)
+                    {
+                        printf("spi_flash_erase_range failed. address=%#08x\n", curren_flash_address + offset);
+                        DisplayError("ERASE ERROR");
+                        indicate_error();
+                    }
                 }
+            }
+            else
+            {
+                // Erased up front
+                ranges[0].first = 0;
+                ranges[0].count = sectorCount;
+                rangeCount = 1;
+            }
 
-                if (offset + count >= length)
+            int range = 0;
+            for (int i = 0; i < sectorCount; ++i)
+            {
+                int offset = block_offset + i * ERASE_BLOCK_SIZE;
+
+                // Display
+                if (progress_update_due(&lastProgressUpdate, offset == 0 || offset + ERASE_BLOCK_SIZE >= length))
                 {
-                    count = length - offset;
+                    if (isUtility)
+                    {
+                        sprintf(tempstring, "Writing Utility");
+                    }
+                    else
+                    {
+                        sprintf(tempstring, "Writing (%d)", part);
+                    }
+
+                    printf("%s - %#08x\n", tempstring, offset);
+                    DisplayProgress((float)offset / (float)(length - ERASE_BLOCK_SIZE) * 100.0f);
+                    DisplayMessage(tempstring);
                 }
 
+                count = length - offset;
+                if (count > ERASE_BLOCK_SIZE) count = ERASE_BLOCK_SIZE;
+
+                while (range < rangeCount && ranges[range].first + ranges[range].count <= i) ++range;
+                if (range == rangeCount || ranges[range].first > i)
+                {
+                    ++skippedBlocks;
+                    totalCount += count;
+                    continue;
+                }
 
                 // flash
-                //printf("Writing offset=0x%x\n", offset);
-                //ret = esp_partition_write(part, offset, data, count);
-                ret = spi_flash_write(curren_flash_address + offset, data, count);
+                const uint8_t* sector = (const uint8_t*)data + i * ERASE_BLOCK_SIZE;
+                ret = spi_flash_write(curren_flash_address + offset, sector, count);
                 if (ret != ESP_OK)
-        		{
-        			printf("spi_flash_write failed. address=%#08x\n", curren_flash_address + offset);
+                {
+                    printf("spi_flash_write failed. address=%#08x\n", curren_flash_address + offset);
                     DisplayError("WRITE ERROR");
                     indicate_error();
-        		}
+                }
 
                 totalCount += count;
             }
 
-            if (totalCount != length)
-            {
-                printf("Size mismatch: lenght=%#08x, totalCount=%#08x\n", length, totalCount);
-                DisplayError("DATA SIZE ERROR");
-                indicate_error();
-            }
-
-
-            // TODO: verify
-
-
-
-
-            // Notify OK
-            sprintf(tempstring, "OK: [%d] Length=%#08x", parts_count, length);
-
-            printf("%s\n", tempstring);
-            //DisplayFooter(tempstring);
+            odroid_readahead_return(stream, data);
+            block_offset += block;
         }
 
-        parts[parts_count++] = slot;
-        curren_flash_address += slot.length;
-
-
-        // Seek to next entry
-        if (fseek(file, nextEntry, SEEK_SET) != 0)
+        if (odroid_readahead_failed(stream))
         {
-            DisplayError("SEEK ERROR");
+            DisplayError("DATA READ ERROR");
             indicate_error();
         }
 
-    }
-
-    close(file);
+        odroid_readahead_stop(stream);
 
-
-    // Utility
-    FILE* util = fopen("/sd/odroid/firmware/utility.bin", "rb");
-    if (util)
-    {
-        if ((curren_flash_address & 0xffff0000) != curren_flash_address)
+        if (totalCount != length)
         {
-            DisplayError("ALIGNMENT ERROR");
+            printf("Size mismatch: lenght=%#08x, totalCount=%#08x\n", length, totalCount);
+            DisplayError("DATA SIZE ERROR");
             indicate_error();
         }
 
 
-        // Get file size
-        fseek(util, 0, SEEK_END);
-        size_t length = ftell(util);
-        fseek(util, 0, SEEK_SET);
-
-        printf("utility.bin - length=%d\n", length);
-
-
-        // TODO: Determine if there is room
+        // TODO: verify
 
 
-        // turn LED off
-        gpio_set_level(GPIO_NUM_2, 0);
 
 
-        // Erase
-        int eraseBlocks = length / ERASE_BLOCK_SIZE;
-        if (eraseBlocks * ERASE_BLOCK_SIZE < length) ++eraseBlocks;
-
-        // Display
-        sprintf(tempstring, "Erasing Utility ...");
+        // Notify OK
+        sprintf(tempstring, "OK: [%d] Length=%#08x, unchanged blocks=%d", part, length, skippedBlocks);
 
         printf("%s\n", tempstring);
-        DisplayProgress(0);
-        DisplayMessage(tempstring);
-
-        esp_err_t ret = spi_flash_erase_range(curren_flash_address, eraseBlocks * ERASE_BLOCK_SIZE);
-        if (ret != ESP_OK)
-        {
-            printf("spi_flash_erase_range failed. eraseBlocks=%d\n", eraseBlocks);
-            DisplayError("ERASE ERROR");
-            indicate_error();
-        }
-
-
-        // turn LED on
-        gpio_set_level(GPIO_NUM_2, 1);
-
-
-        // Write data
-        int totalCount = 0;
-        for (int offset = 0; offset < length; offset += ERASE_BLOCK_SIZE)
-        {
-            // Display
-            sprintf(tempstring, "Writing Utility");
-
-            printf("%s - %#08x\n", tempstring, offset);
-            DisplayProgress((float)offset / (float)(length - ERASE_BLOCK_SIZE) * 100.0f);
-            DisplayMessage(tempstring);
-
-            // read
-            //printf("Reading offset=0x%x\n", offset);
-            count = fread(data, 1, ERASE_BLOCK_SIZE, util);
-            if (count <= 0)
-            {
-                DisplayError("DATA READ ERROR");
-                indicate_error();
-            }
-
-            if (offset + count >= length)
-            {
-                count = length - offset;
-            }
-
-
-            // flash
-            //printf("Writing offset=0x%x\n", offset);
-            //ret = esp_partition_write(part, offset, data, count);
-            ret = spi_flash_write(curren_flash_address + offset, data, count);
-            if (ret != ESP_OK)
-            {
-                printf("spi_flash_write failed. address=%#08x\n", curren_flash_address + offset);
-                DisplayError("WRITE ERROR");
-                indicate_error();
-            }
-
-            totalCount += count;
-        }
-
-        // Add partition
-        odroid_partition_t util_part;
-        memset(&util_part, 0, sizeof(util_part));
-
-
-        util_part.type = PART_TYPE_APP;
-        util_part.subtype = PART_SUBTYPE_TEST;
-
-        strcpy((char*)util_part.label, "utility");
-
-        util_part.flags = 0;
-
-        // 64k align
-        if ((length & 0xffff0000) != length) length += 0x10000;
-        util_part.length = length & 0xffff0000;
-
-
-        parts[parts_count++] = util_part;
-
-        fclose(util);
+        //DisplayFooter(tempstring);
     }
 
+    odroid_sdcard_file_close(file);
+    if (util) odroid_sdcard_file_close(util);
+
 
     // Write partition table
-    write_partition_table(parts, parts_count);
+    write_partition_table(parts, plan, parts_count);
+
+    odroid_spi_bus_stats_print();
 
 
-    free(data);
+    free(current);
+    free(kept);
+    free(plan);
+    free(sources);
+    free(parts);
+    free(verify);
 
     // Close SD card
     odroid_sdcard_close();
@@ -944,7 +1094,16 @@ static void ui_draw_title()
 
 static void ui_draw_page(char** files, int fileCount, int currentItem)
 {
-    printf("%s: HEAP=%#010x\n", __func__, esp_get_free_heap_size());
+    ui_glyph_cache_stats glyphStats;
+    ui_glyph_cache_stats_get(&glyphStats);
+
+    odroid_sdcard_pool_stats poolStats;
+    odroid_sdcard_pool_stats_get(&poolStats);
+
+    printf("%s: HEAP=%#010x, glyph cache hits=%u, misses=%u, evictions=%u, bytes=%u\n", __func__,
+        esp_get_free_heap_size(), glyphStats.hits, glyphStats.misses, glyphStats.evictions, glyphStats.bytes_used);
+    printf("%s: file pool opens=%u, reuses=%u, closes=%u, evictions=%u, open=%d/%d\n", __func__,
+        poolStats.opens, poolStats.reuses, poolStats.closes, poolStats.evictions, poolStats.open_now, poolStats.cap);
 
     int page = currentItem / ITEM_COUNT;
     page *= ITEM_COUNT;
@@ -1041,6 +1200,52 @@ static void ui_draw_page(char** files, int fileCount, int currentItem)
 	}
 }
 
+// Read rate of the selected file for each block size, so the flash block
+// size can be checked against a given card.
+#define BENCHMARK_LENGTH (1024 * 1024)
+
+static void ui_sdcard_benchmark(const char* fullPath)
+{
+    const size_t BLOCK_SIZES[] = { 4096, 8192, 16384, 32768, 65536 };
+    const int BLOCK_SIZE_COUNT = sizeof(BLOCK_SIZES) / sizeof(BLOCK_SIZES[0]);
+    char text[32];
+
+    ui_draw_title();
+    DisplayHeader("SD card read rate");
+    DisplayFooter("Reading ...");
+
+    UG_FontSelect(&FONT_8X12);
+    UG_SetForecolor(C_BLACK);
+    UG_SetBackcolor(C_WHITE);
+
+    for (int i = 0; i < BLOCK_SIZE_COUNT; ++i)
+    {
+        int rate = odroid_sdcard_read_rate(fullPath, BLOCK_SIZES[i], BENCHMARK_LENGTH);
+        if (rate < 0)
+        {
+            sprintf(text, "%2d KB: error", (int)(BLOCK_SIZES[i] / 1024));
+        }
+        else
+        {
+            sprintf(text, "%2d KB: %5d KB/s", (int)(BLOCK_SIZES[i] / 1024), rate);
+        }
+
+        UG_PutString(320 / 2 - (16 * 9 / 2), 16 + 8 + 16 + 8 + (i * 16), text);
+        UpdateDisplay();
+    }
+
+    DisplayFooter("[B] Back");
+
+    input_event_flush();
+    while (true)
+    {
+        odroid_input_event event;
+        input_event_get(&event, -1);
+
+        if (event.type == ODROID_INPUT_EVENT_PRESS && event.button == ODROID_INPUT_B) break;
+    }
+}
+
 const char* ui_choose_file(const char* path)
 {
     const char* result = NULL;
@@ -1063,20 +1268,23 @@ const char* ui_choose_file(const char* path)
     int currentItem = 0;
     ui_draw_page(files, fileCount, currentItem);
 
-    odroid_gamepad_state previousState;
-    input_read(&previousState);
+    input_event_flush();
 
     while (true)
     {
-		odroid_gamepad_state state;
-		input_read(&state);
+        odroid_input_event event;
+        input_event_get(&event, -1);
+
+        // Navigation acts on press and hold-to-repeat, actions on press only
+        if (event.type == ODROID_INPUT_EVENT_RELEASE) continue;
+        bool pressed = (event.type == ODROID_INPUT_EVENT_PRESS);
 
         int page = currentItem / ITEM_COUNT;
         page *= ITEM_COUNT;
 
 		if (fileCount > 0)
 		{
-	        if(!previousState.values[ODROID_INPUT_DOWN] && state.values[ODROID_INPUT_DOWN])
+	        if(event.button == ODROID_INPUT_DOWN)
 	        {
 	            if (fileCount > 0)
 				{
@@ -1092,7 +1300,7 @@ const char* ui_choose_file(const char* path)
 					}
 				}
 	        }
-	        else if(!previousState.values[ODROID_INPUT_UP] && state.values[ODROID_INPUT_UP])
+	        else if(event.button == ODROID_INPUT_UP)
 	        {
 	            if (fileCount > 0)
 				{
@@ -1108,7 +1316,7 @@ const char* ui_choose_file(const char* path)
 					}
 				}
 	        }
-	        else if(!previousState.values[ODROID_INPUT_RIGHT] && state.values[ODROID_INPUT_RIGHT])
+	        else if(event.button == ODROID_INPUT_RIGHT)
 	        {
 	            if (fileCount > 0)
 				{
@@ -1124,7 +1332,7 @@ const char* ui_choose_file(const char* path)
 					}
 				}
 	        }
-	        else if(!previousState.values[ODROID_INPUT_LEFT] && state.values[ODROID_INPUT_LEFT])
+	        else if(event.button == ODROID_INPUT_LEFT)
 	        {
 	            if (fileCount > 0)
 				{
@@ -1145,7 +1353,7 @@ const char* ui_choose_file(const char* path)
 					}
 				}
 	        }
-	        else if(!previousState.values[ODROID_INPUT_A] && state.values[ODROID_INPUT_A])
+	        else if(pressed && event.button == ODROID_INPUT_A)
 	        {
 	            size_t fullPathLength = strlen(path) + 1 + strlen(files[currentItem]) + 1;
 
@@ -1159,7 +1367,24 @@ const char* ui_choose_file(const char* path)
 	            result = fullPath;
                 break;
 	        }
-            else if (!previousState.values[ODROID_INPUT_MENU] && state.values[ODROID_INPUT_MENU])
+            else if (pressed && event.button == ODROID_INPUT_SELECT)
+            {
+                size_t fullPathLength = strlen(path) + 1 + strlen(files[currentItem]) + 1;
+
+                char* fullPath = (char*)malloc(fullPathLength);
+                if (!fullPath) abort();
+
+                strcpy(fullPath, path);
+                strcat(fullPath, "/");
+                strcat(fullPath, files[currentItem]);
+
+                ui_sdcard_benchmark(fullPath);
+                free(fullPath);
+
+                input_event_flush();
+                ui_draw_page(files, fileCount, currentItem);
+            }
+            else if (pressed && event.button == ODROID_INPUT_MENU)
             {
                 ui_draw_title();
                 DisplayMessage("Exiting ...");
@@ -1171,9 +1396,6 @@ const char* ui_choose_file(const char* path)
                 abort();
             }
 		}
-
-        previousState = state;
-        vTaskDelay(10 / portTICK_PERIOD_MS);
     }
 
     odroid_sdcard_files_free(files, fileCount);
@@ -1181,20 +1403,69 @@ const char* ui_choose_file(const char* path)
     return result;
 }
 
-static void menu_main()
+static bool ui_calibrate_sample(const char* message, int* out_x, int* out_y)
 {
-    sprintf(tempstring,"Ver: %s-%s", COMPILEDATE, GITREV);
+    ui_draw_title();
+    DisplayMessage(message);
+    DisplayFooter("[A] Sample  [B] Cancel");
+
+    input_event_flush();
+    while (true)
+    {
+        odroid_input_event event;
+        input_event_get(&event, -1);
+
+        if (event.type != ODROID_INPUT_EVENT_PRESS) continue;
+
+        if (event.button == ODROID_INPUT_A)
+        {
+            input_read_axes(out_x, out_y, 64);
+            printf("%s: '%s' x=%d, y=%d\n", __func__, message, *out_x, *out_y);
+            return true;
+        }
+        else if (event.button == ODROID_INPUT_B)
+        {
+            return false;
+        }
+    }
+}
+
+static void ui_calibrate_dpad()
+{
+    int restX, restY, left, right, up, down, unused;
+
+    if (!ui_calibrate_sample("Release D-pad", &restX, &restY)) return;
+    if (!ui_calibrate_sample("Hold LEFT", &left, &unused)) return;
+    if (!ui_calibrate_sample("Hold RIGHT", &right, &unused)) return;
+    if (!ui_calibrate_sample("Hold UP", &unused, &up)) return;
+    if (!ui_calibrate_sample("Hold DOWN", &unused, &down)) return;
 
     ui_draw_title();
 
-    // Check SD card
-    esp_err_t ret = odroid_sdcard_open(SD_CARD);
-    if (ret != ESP_OK)
+    odroid_input_calibration calibration;
+    if (!input_axis_thresholds_from_samples(&calibration.x, restX, left, right) ||
+        !input_axis_thresholds_from_samples(&calibration.y, restY, up, down))
     {
-        DisplayError("SD CARD ERROR");
-        indicate_error();
+        DisplayError("CALIBRATION RANGE ERROR");
+    }
+    else if (input_calibration_set(&calibration) != ESP_OK)
+    {
+        DisplayError("CALIBRATION SAVE ERROR");
+    }
+    else
+    {
+        DisplayMessage("Calibration saved");
     }
 
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+}
+
+static void menu_main()
+{
+    sprintf(tempstring,"Ver: %s-%s", COMPILEDATE, GITREV);
+
+    ui_draw_title();
+
 
     // Check for /odroid/firmware
 
@@ -1214,6 +1485,109 @@ static void menu_main()
 }
 
 
+static esp_err_t startup_lcd_bus()
+{
+    ili9341_bus_init();
+    return ESP_OK;
+}
+
+static esp_err_t startup_panel()
+{
+    ili9341_panel_init();
+    return ESP_OK;
+}
+
+static esp_err_t startup_ui()
+{
+    UG_Init(&gui, ui_fb_pset, 320, 240);
+    ui_fb_init(fb, 320, 240);
+    ui_glyph_cache_init(GLYPH_CACHE_BUDGET);
+
+    ui_draw_title();
+    return ESP_OK;
+}
+
+static esp_err_t startup_title()
+{
+    UpdateDisplay();
+    return ESP_OK;
+}
+
+static esp_err_t startup_sdcard()
+{
+    return odroid_sdcard_open(SD_CARD);
+}
+
+// The SD card attaches to the bus the LCD brings up, then mounts while the
+// panel sits in its reset delays and the title is drawn. The title frame
+// replaces the old full-screen clear.
+enum
+{
+    STARTUP_LCD_BUS = 0,
+    STARTUP_PANEL,
+    STARTUP_UI,
+    STARTUP_TITLE,
+    STARTUP_SDCARD,
+
+    STARTUP_STAGE_COUNT
+};
+
+static const odroid_startup_stage StartupStages[STARTUP_STAGE_COUNT] = {
+    { "lcd_bus", startup_lcd_bus, 0, 0 },
+    { "panel", startup_panel, ODROID_STARTUP_DEPENDS(STARTUP_LCD_BUS), 0 },
+    { "ui", startup_ui, 0, 1 },
+    { "title", startup_title, ODROID_STARTUP_DEPENDS(STARTUP_PANEL) | ODROID_STARTUP_DEPENDS(STARTUP_UI), 0 },
+    { "sdcard", startup_sdcard, ODROID_STARTUP_DEPENDS(STARTUP_LCD_BUS), 1 },
+};
+
+// Runs before the display and SD card are touched. Only returns when the
+// menu should be shown.
+static void fast_boot_check()
+{
+    odroid_gamepad_state state = input_read_raw();
+    for (int i = 0; i < ODROID_INPUT_MAX; ++i)
+    {
+        if (state.values[i])
+        {
+            printf("fast boot: button %d held, showing menu.\n", i);
+            return;
+        }
+    }
+
+    const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_APP,
+        ESP_PARTITION_SUBTYPE_APP_OTA_0, NULL);
+    if (partition == NULL)
+    {
+        printf("fast boot: no OTA_0 partition.\n");
+        return;
+    }
+
+    // Checks every segment and the appended checksum/hash, so a partly
+    // flashed or corrupt image falls back to the menu instead of being
+    // made the boot partition.
+    const esp_partition_pos_t position = {
+        .offset = partition->address,
+        .size = partition->size
+    };
+    esp_image_metadata_t metadata;
+    esp_err_t err = esp_image_verify(ESP_IMAGE_VERIFY_SILENT, &position, &metadata);
+    if (err != ESP_OK)
+    {
+        printf("fast boot: no valid application in OTA_0 (%d).\n", err);
+        return;
+    }
+
+    err = esp_ota_set_boot_partition(partition);
+    if (err != ESP_OK)
+    {
+        printf("fast boot: esp_ota_set_boot_partition failed (%d).\n", err);
+        return;
+    }
+
+    printf("fast boot: restarting into OTA_0 at %d ms.\n", (int)(esp_timer_get_time() / 1000));
+    esp_restart();
+}
+
 void app_main(void)
 {
     const char* VER_PREFIX = "Ver: ";
@@ -1232,16 +1606,42 @@ void app_main(void)
 
     input_init();
 
+#if FAST_BOOT_ENABLED
+    fast_boot_check();
+#endif
 
     // turn LED on
     gpio_set_direction(GPIO_NUM_2, GPIO_MODE_OUTPUT);
     gpio_set_level(GPIO_NUM_2, 1);
 
 
-    ili9341_init();
-    ili9341_clear(0xffff);
+    // Hold SELECT + START at power on to calibrate the D-pad. Calibration
+    // runs before the SD card stage so a missing or bad card can not lock
+    // the user out of it.
+    odroid_gamepad_state bootState = input_read_raw();
+    bool calibrate = bootState.values[ODROID_INPUT_SELECT] && bootState.values[ODROID_INPUT_START];
+
+    esp_err_t sdcardResult;
+    if (calibrate)
+    {
+        odroid_startup_run(StartupStages, STARTUP_SDCARD);
+        ui_calibrate_dpad();
+
+        sdcardResult = startup_sdcard();
+    }
+    else
+    {
+        odroid_startup_run(StartupStages, STARTUP_STAGE_COUNT);
+        sdcardResult = odroid_startup_result(STARTUP_SDCARD);
+    }
+
+    if (sdcardResult != ESP_OK)
+    {
+        DisplayError("SD CARD ERROR");
+        indicate_error();
+    }
 
-    UG_Init(&gui, pset, 320, 240);
+    printf("boot: menu ready at %d ms.\n", (int)(esp_timer_get_time() / 1000));
 
     menu_main();
 
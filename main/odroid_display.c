@@ -8,6 +8,8 @@
 #include <string.h>
 
 #include "odroid_display.h"
+#include "odroid_spi_bus.h"
+#include "ui_blit.h"
 
 
 const gpio_num_t SPI_PIN_NUM_MISO = GPIO_NUM_19;
@@ -177,8 +179,10 @@ static void ili_init()
 
     //Send all the commands
     while (ili_init_cmds[cmd].databytes!=0xff) {
+        odroid_spi_bus_acquire(ODROID_SPI_DEVICE_LCD);
         ili_cmd(spi, ili_init_cmds[cmd].cmd);
         ili_data(spi, ili_init_cmds[cmd].data, ili_init_cmds[cmd].databytes & 0x7f);
+        odroid_spi_bus_release(ODROID_SPI_DEVICE_LCD);
         if (ili_init_cmds[cmd].databytes&0x80) {
             vTaskDelay(100 / portTICK_RATE_MS);
         }
@@ -306,6 +310,8 @@ void ili9341_write_frame(uint16_t* buffer)
 {
     short x, y;
 
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_LCD);
+
     if (buffer == NULL)
     {
         // clear the buffer
@@ -332,6 +338,8 @@ void ili9341_write_frame(uint16_t* buffer)
             send_continue_line(buffer + y * displayWidth, displayWidth, 4);
         }
     }
+
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_LCD);
 }
 
 void ili9341_write_frame_rectangle(short left, short top, short width, short height, uint16_t* buffer)
@@ -341,6 +349,8 @@ void ili9341_write_frame_rectangle(short left, short top, short width, short hei
     if (left < 0 || top < 0) abort();
     if (width < 1 || height < 1) abort();
 
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_LCD);
+
     send_reset_drawing(left, top, width, height);
 
     if (buffer == NULL)
@@ -366,10 +376,14 @@ void ili9341_write_frame_rectangle(short left, short top, short width, short hei
             if (alt > 1) alt = 0;
         }
     }
+
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_LCD);
 }
 
 void ili9341_clear(uint16_t color)
 {
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_LCD);
+
     send_reset_drawing(0, 0, 320, 240);
 
     // clear the buffer
@@ -383,6 +397,8 @@ void ili9341_clear(uint16_t color)
     {
         send_continue_line(line[0], 320, 1);
     }
+
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_LCD);
 }
 
 void ili9341_write_frame_rectangleLE(short left, short top, short width, short height, uint16_t* buffer)
@@ -392,6 +408,8 @@ void ili9341_write_frame_rectangleLE(short left, short top, short width, short h
     if (left < 0 || top < 0) abort();
     if (width < 1 || height < 1) abort();
 
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_LCD);
+
     send_reset_drawing(left, top, width, height);
 
     if (buffer == NULL)
@@ -423,10 +441,52 @@ void ili9341_write_frame_rectangleLE(short left, short top, short width, short h
             if (alt > 1) alt = 0;
         }
     }
+
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_LCD);
 }
 
-void ili9341_init()
+// Like ili9341_write_frame_rectangleLE, but the rectangle is a window of a
+// larger buffer whose rows are 'stride' pixels apart. Rows are batched
+// LINE_COUNT at a time per transaction.
+void ili9341_write_frame_rectangle_strideLE(short left, short top, short width, short height, short stride, uint16_t* buffer)
+{
+    if (left < 0 || top < 0) abort();
+    if (width < 1 || height < 1) abort();
+    if (width > 320 || stride < width) abort();
+    if (buffer == NULL) abort();
+
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_LCD);
+
+    send_reset_drawing(left, top, width, height);
+
+    short alt = 0;
+    for (short y = 0; y < height; y += LINE_COUNT)
+    {
+        short lines = height - y;
+        if (lines > LINE_COUNT) lines = LINE_COUNT;
+
+        uint16_t* dst = line[alt];
+        for (short j = 0; j < lines; ++j)
+        {
+            ui_blit_swap_row(dst, buffer + (y + j) * stride, width);
+            dst += width;
+        }
+
+        send_continue_line(line[alt], width, lines);
+
+        ++alt;
+        if (alt > 1) alt = 0;
+    }
+
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_LCD);
+}
+
+// Brings up HSPI and attaches the LCD. The SD card attaches to the same bus
+// afterwards, so this has to run before odroid_sdcard_open.
+void ili9341_bus_init()
 {
+    odroid_spi_bus_init();
+
 	// Initialize transactions
     for (int x=0; x<8; x++) {
         memset(&trans[x], 0, sizeof(spi_transaction_t));
@@ -472,8 +532,13 @@ void ili9341_init()
     //Attach the LCD to the SPI bus
     ret=spi_bus_add_device(HSPI_HOST, &devcfg, &spi);
     assert(ret==ESP_OK);
+}
 
-
+// Sends the panel init sequence (with its reset delays) and turns on the
+// backlight. The bus is only held per command, so SD traffic can use it
+// during the delays.
+void ili9341_panel_init()
+{
     //Initialize the LCD
 	printf("LCD: calling ili_init.\n");
     ili_init();
@@ -483,3 +548,9 @@ void ili9341_init()
 
     printf("LCD Initialized (%d Hz).\n", LCD_SPI_CLOCK_RATE);
 }
+
+void ili9341_init()
+{
+    ili9341_bus_init();
+    ili9341_panel_init();
+}
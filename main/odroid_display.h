@@ -1,9 +1,12 @@
 #pragma once
 
 void ili9341_init();
+void ili9341_bus_init();
+void ili9341_panel_init();
 void ili9341_write_frame(uint16_t* buffer);
 void ili9341_write_frame_rectangle(short left, short top, short width, short height, uint16_t* buffer);
 void ili9341_write_frame_rectangleLE(short left, short top, short width, short height, uint16_t* buffer);
+void ili9341_write_frame_rectangle_strideLE(short left, short top, short width, short height, short stride, uint16_t* buffer);
 
 void ili9341_clear(uint16_t color);
 
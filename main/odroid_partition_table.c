@@ -0,0 +1,60 @@
+#include "odroid_partition_table.h"
+
+#include "esp_spi_flash.h"
+#include "rom/md5_hash.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+static partition_table_t table;
+static bool loaded;
+
+
+static void rom_md5(const void* data, size_t length, uint8_t digest[16])
+{
+    struct MD5Context context;
+
+    MD5Init(&context);
+    MD5Update(&context, data, length);
+    MD5Final(digest, &context);
+}
+
+const partition_table_t* odroid_partition_table_get()
+{
+    if (loaded) return &table;
+
+    uint8_t* raw = malloc(PARTITION_TABLE_MAX_LEN);
+    if (!raw)
+    {
+        printf("%s: malloc failed.\n", __func__);
+        return NULL;
+    }
+
+    esp_err_t err = spi_flash_read(CONFIG_PARTITION_TABLE_OFFSET, raw, PARTITION_TABLE_MAX_LEN);
+    if (err != ESP_OK)
+    {
+        printf("%s: spi_flash_read failed (%d).\n", __func__, err);
+        free(raw);
+        return NULL;
+    }
+
+    partition_table_result_t result = partition_table_parse(&table, raw, PARTITION_TABLE_MAX_LEN, rom_md5);
+    free(raw);
+
+    if (result != PARTITION_TABLE_OK)
+    {
+        printf("%s: invalid partition table (%d).\n", __func__, result);
+        return NULL;
+    }
+
+    printf("%s: %d partitions%s.\n", __func__, table.count, table.has_md5 ? ", MD5 OK" : "");
+
+    loaded = true;
+    return &table;
+}
+
+void odroid_partition_table_invalidate()
+{
+    loaded = false;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "partition_table.h"
+
+
+// The partition table is read from flash and validated once, then served
+// from memory until odroid_partition_table_invalidate (after a write).
+// Returns NULL (and logs why) when the table can not be read or is
+// invalid; the caller reports the error.
+const partition_table_t* odroid_partition_table_get();
+void odroid_partition_table_invalidate();
@@ -0,0 +1,191 @@
+#include "odroid_readahead.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define READER_STACK_SIZE (3072)
+#define READER_CORE (1)
+
+typedef struct
+{
+    int index;
+    ssize_t length;     // 0 at the end of the range, -1 on error
+} filled_block;
+
+struct odroid_readahead
+{
+    odroid_sdcard_file* file;
+    size_t remaining;
+    size_t block_size;
+    int block_count;
+    void* blocks[ODROID_READAHEAD_BLOCK_MAX];
+
+    QueueHandle_t free_queue;   // block indices ready to fill, -1 stops
+    QueueHandle_t filled_queue; // filled_block in file order
+    SemaphoreHandle_t done;
+
+    bool finished;
+    bool failed;
+};
+
+
+static void reader_task(void* arg)
+{
+    odroid_readahead* stream = (odroid_readahead*)arg;
+
+    while (true)
+    {
+        int index;
+        xQueueReceive(stream->free_queue, &index, portMAX_DELAY);
+        if (index < 0) break;
+
+        filled_block filled = { index, 0 };
+
+        size_t length = stream->remaining;
+        if (length > stream->block_size) length = stream->block_size;
+
+        if (length > 0)
+        {
+            filled.length = odroid_sdcard_file_read(stream->file, stream->blocks[index], length);
+            if (filled.length != (ssize_t)length) filled.length = -1;
+            else stream->remaining -= length;
+        }
+
+        xQueueSend(stream->filled_queue, &filled, portMAX_DELAY);
+
+        if (filled.length <= 0) break;
+    }
+
+    xSemaphoreGive(stream->done);
+    vTaskDelete(NULL);
+}
+
+odroid_readahead* odroid_readahead_start(odroid_sdcard_file* file, off_t offset, size_t length,
+    size_t block_size, int block_count)
+{
+    if (block_count < 1 || block_count > ODROID_READAHEAD_BLOCK_MAX) abort();
+
+    odroid_readahead* stream = calloc(1, sizeof(odroid_readahead));
+    if (!stream) return NULL;
+
+    stream->file = file;
+    stream->remaining = length;
+    stream->block_size = block_size;
+
+    // Take what the heap allows; one block still works, just without overlap
+    for (int i = 0; i < block_count; ++i)
+    {
+        stream->blocks[i] = odroid_sdcard_block_alloc(block_size);
+        if (!stream->blocks[i]) break;
+
+        ++stream->block_count;
+    }
+
+    if (stream->block_count < block_count)
+    {
+        printf("%s: %d of %d blocks allocated.\n", __func__, stream->block_count, block_count);
+    }
+
+    // One spare slot in the free queue for the stop request
+    stream->free_queue = xQueueCreate(ODROID_READAHEAD_BLOCK_MAX + 1, sizeof(int));
+    stream->filled_queue = xQueueCreate(ODROID_READAHEAD_BLOCK_MAX + 1, sizeof(filled_block));
+    stream->done = xSemaphoreCreateBinary();
+
+    if (stream->block_count < 1 || !stream->free_queue || !stream->filled_queue || !stream->done ||
+        odroid_sdcard_file_seek(file, offset, SEEK_SET) < 0)
+    {
+        printf("%s: setup failed.\n", __func__);
+        if (stream->done) xSemaphoreGive(stream->done);
+        odroid_readahead_stop(stream);
+        return NULL;
+    }
+
+    for (int i = 0; i < stream->block_count; ++i)
+    {
+        xQueueSend(stream->free_queue, &i, 0);
+    }
+
+    BaseType_t ret = xTaskCreatePinnedToCore(&reader_task, "readahead", READER_STACK_SIZE,
+        stream, uxTaskPriorityGet(NULL), NULL, READER_CORE);
+    if (ret != pdPASS)
+    {
+        printf("%s: xTaskCreatePinnedToCore failed.\n", __func__);
+        xSemaphoreGive(stream->done);
+        odroid_readahead_stop(stream);
+        return NULL;
+    }
+
+    return stream;
+}
+
+const void* odroid_readahead_borrow(odroid_readahead* stream, size_t* out_length)
+{
+    *out_length = 0;
+    if (stream->finished) return NULL;
+
+    filled_block filled;
+    xQueueReceive(stream->filled_queue, &filled, portMAX_DELAY);
+
+    if (filled.length <= 0)
+    {
+        stream->finished = true;
+        stream->failed = (filled.length < 0);
+        return NULL;
+    }
+
+    *out_length = filled.length;
+    return stream->blocks[filled.index];
+}
+
+void odroid_readahead_return(odroid_readahead* stream, const void* block)
+{
+    for (int i = 0; i < stream->block_count; ++i)
+    {
+        if (stream->blocks[i] == block)
+        {
+            xQueueSend(stream->free_queue, &i, portMAX_DELAY);
+            return;
+        }
+    }
+
+    printf("%s: unknown block %p.\n", __func__, block);
+    abort();
+}
+
+bool odroid_readahead_failed(const odroid_readahead* stream)
+{
+    return stream->failed;
+}
+
+void odroid_readahead_stop(odroid_readahead* stream)
+{
+    if (!stream) return;
+
+    if (stream->done)
+    {
+        // Ahead of any returned blocks so the task does not read them first.
+        // It may already have exited, in which case this is never read.
+        const int stop = -1;
+        if (stream->free_queue) xQueueSendToFront(stream->free_queue, &stop, 0);
+
+        xSemaphoreTake(stream->done, portMAX_DELAY);
+        vSemaphoreDelete(stream->done);
+    }
+
+    if (stream->filled_queue) vQueueDelete(stream->filled_queue);
+    if (stream->free_queue) vQueueDelete(stream->free_queue);
+
+    for (int i = 0; i < stream->block_count; ++i)
+    {
+        free(stream->blocks[i]);
+    }
+
+    free(stream);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "odroid_sdcard.h"
+
+
+// Streams a byte range of a file through a small ring of DMA blocks. A
+// background task keeps reading ahead of the consumer, which borrows each
+// filled block in order and returns it when done so it can be refilled.
+// The file must not be used by anyone else while the stream is running.
+typedef struct odroid_readahead odroid_readahead;
+
+#define ODROID_READAHEAD_BLOCK_MAX (8)
+
+// Allocates up to 'block_count' blocks of 'block_size' (at least one) and
+// starts reading 'length' bytes from 'offset'. Returns NULL on failure.
+odroid_readahead* odroid_readahead_start(odroid_sdcard_file* file, off_t offset, size_t length,
+    size_t block_size, int block_count);
+
+// Next block in file order. Returns NULL at the end of the range, or on a
+// read error (odroid_readahead_failed tells which).
+const void* odroid_readahead_borrow(odroid_readahead* stream, size_t* out_length);
+void odroid_readahead_return(odroid_readahead* stream, const void* block);
+bool odroid_readahead_failed(const odroid_readahead* stream);
+
+// Stops the reader task and frees the blocks. Safe at any point.
+void odroid_readahead_stop(odroid_readahead* stream);
@@ -1,4 +1,5 @@
 #include "odroid_sdcard.h"
+#include "odroid_spi_bus.h"
 
 //#include "esp_err.h"
 #include "esp_log.h"
@@ -6,13 +7,21 @@
 #include "driver/sdmmc_host.h"
 #include "driver/sdspi_host.h"
 #include "sdmmc_cmd.h"
+#include "ff.h"
 #include "esp_heap_caps.h"
+#include "soc/soc_memory_layout.h"
 #include "esp_spiffs.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "rom/crc.h"
 
 #include <dirent.h>
+#include <sys/stat.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <ctype.h>
+#include <errno.h>
 
 
 
@@ -22,7 +31,53 @@
 #define SD_PIN_NUM_CS 22
 
 
+// Clocks tried when mounting, fastest first
+static const int frequencies[] = { SDMMC_FREQ_HIGHSPEED, 26000, SDMMC_FREQ_DEFAULT };
+#define FREQUENCY_COUNT (sizeof(frequencies) / sizeof(frequencies[0]))
+
+#define PROBE_SECTORS (32)
+
+#define SDCARD_NAMESPACE "sdcard"
+
+// A card recorded below the fastest clock is mounted one step faster once
+// every this many mounts, so a card that failed only once can move back up
+#define RETRY_FASTER_INTERVAL (16)
+
+// The card is the only FATFS volume, so it is always logical drive 0
+#define SDCARD_FAT_DRIVE "0:"
+#define SDCARD_SECTOR_SIZE (512)
+
 static bool isOpen = false;
+static sdmmc_card_t* card;
+static char basePath[16];
+
+
+#define POOL_CAP_MAX (ODROID_SDCARD_MAX_FILES - ODROID_SDCARD_POOL_RESERVE)
+
+typedef struct
+{
+    FILE* file;
+    char* path;
+    bool in_use;
+    uint32_t last_used;
+} pool_entry;
+
+static pool_entry pool[POOL_CAP_MAX];
+static int poolCap = ODROID_SDCARD_POOL_DEFAULT_CAP;
+static uint32_t poolClock;
+static odroid_sdcard_pool_stats poolStats;
+
+
+struct odroid_sdcard_file
+{
+    int fd;                 // VFS handle, fragmented files only
+    bool contiguous;
+    uint32_t first_sector;
+    size_t size;
+    size_t position;
+    uint8_t* sector;        // partial sector reads
+    uint32_t sector_lba;
+};
 
 
 
@@ -94,9 +149,12 @@ int odroid_sdcard_files_get(const char* path, const char* extension, char*** fil
     if (!result) abort();
 
 
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+
     DIR *dir = opendir(path);
     if( dir == NULL )
     {
+        odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
         printf("opendir failed.\n");
         //abort();
         return 0;
@@ -153,6 +211,8 @@ int odroid_sdcard_files_get(const char* path, const char* extension, char*** fil
     }
 
     closedir(dir);
+
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
     free(temp);
 
     sort_files(result, count);
@@ -173,6 +233,200 @@ void odroid_sdcard_files_free(char** files, int count)
     free(files);
 }
 
+static sdspi_slot_config_t sdcard_slot_config()
+{
+	sdspi_slot_config_t slot_config = SDSPI_SLOT_CONFIG_DEFAULT();
+	slot_config.gpio_miso = (gpio_num_t)SD_PIN_NUM_MISO;
+	slot_config.gpio_mosi = (gpio_num_t)SD_PIN_NUM_MOSI;
+	slot_config.gpio_sck  = (gpio_num_t)SD_PIN_NUM_CLK;
+	slot_config.gpio_cs = (gpio_num_t)SD_PIN_NUM_CS;
+	// Same as SDSPI_SLOT_CONFIG_DEFAULT; spelled out because it must match
+	// the channel ili9341_bus_init gives HSPI for the LCD.
+	slot_config.dma_channel = 1;
+
+    return slot_config;
+}
+
+// Initializes the card without mounting it, only to read the CID. The
+// clock never leaves the 400 kHz probing rate, so any card passes.
+static esp_err_t sdcard_identify(sdmmc_cid_t* out_cid)
+{
+    sdmmc_host_t host = SDSPI_HOST_DEFAULT();
+    host.slot = HSPI_HOST;
+    host.max_freq_khz = SDMMC_FREQ_PROBING;
+
+    sdspi_slot_config_t slot_config = sdcard_slot_config();
+    sdmmc_card_t identified;
+
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+
+    esp_err_t ret = sdspi_host_init();
+    if (ret == ESP_OK)
+    {
+        ret = sdspi_host_init_slot(host.slot, &slot_config);
+        if (ret == ESP_OK) ret = sdmmc_card_init(&host, &identified);
+
+        sdspi_host_deinit();
+    }
+
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+
+    if (ret != ESP_OK)
+    {
+        printf("odroid_sdcard_open: card identification failed (%d)\n", ret);
+        return ret;
+    }
+
+    *out_cid = identified.cid;
+    return ESP_OK;
+}
+
+static esp_err_t sdcard_mount(const char* base_path, int freq_khz)
+{
+    sdmmc_host_t host = SDSPI_HOST_DEFAULT();
+	host.slot = HSPI_HOST; // HSPI_HOST;
+    host.max_freq_khz = freq_khz;
+
+	sdspi_slot_config_t slot_config = sdcard_slot_config();
+
+	// Options for mounting the filesystem.
+	// If format_if_mount_failed is set to true, SD card will be partitioned and
+	// formatted in case when mounting fails.
+	esp_vfs_fat_sdmmc_mount_config_t mount_config;
+    memset(&mount_config, 0, sizeof(mount_config));
+
+	mount_config.format_if_mount_failed = false;
+	mount_config.max_files = ODROID_SDCARD_MAX_FILES;
+
+
+	// Use settings defined above to initialize SD card and mount FAT filesystem.
+	// Note: esp_vfs_fat_sdmmc_mount is an all-in-one convenience function.
+	// Please check its source code and implement error recovery when developing
+	// production applications.
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+	esp_err_t ret = esp_vfs_fat_sdmmc_mount(base_path, &host, &slot_config, &mount_config, &card);
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+
+    if (ret != ESP_OK)
+    {
+        printf("odroid_sdcard_open: esp_vfs_fat_sdmmc_mount failed at %d kHz (%d)\n", freq_khz, ret);
+        card = NULL;
+    }
+
+    return ret;
+}
+
+static void sdcard_unmount()
+{
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+    esp_vfs_fat_sdmmc_unmount();
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+
+    card = NULL;
+}
+
+// Reads the same sectors twice and compares them. Returns the measured
+// read rate in KB/s, or 0 if the card misbehaved.
+static int sdcard_probe()
+{
+    const size_t length = PROBE_SECTORS * 512;
+
+    uint8_t* first = heap_caps_malloc(length, MALLOC_CAP_DMA);
+    uint8_t* second = heap_caps_malloc(length, MALLOC_CAP_DMA);
+    if (!first || !second)
+    {
+        free(first);
+        free(second);
+        return 0;
+    }
+
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = sdmmc_read_sectors(card, first, 0, PROBE_SECTORS);
+    if (ret == ESP_OK)
+    {
+        ret = sdmmc_read_sectors(card, second, 0, PROBE_SECTORS);
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+
+    int rate = 0;
+    if (ret != ESP_OK)
+    {
+        printf("odroid_sdcard_open: probe read failed (%d)\n", ret);
+    }
+    else if (memcmp(first, second, length) != 0)
+    {
+        printf("odroid_sdcard_open: probe reads differ\n");
+    }
+    else
+    {
+        if (elapsed < 1) elapsed = 1;
+        rate = (int)((length * 2 * 1000000LL / 1024) / elapsed);
+        if (rate < 1) rate = 1;
+    }
+
+    free(first);
+    free(second);
+
+    return rate;
+}
+
+// NVS keys for the card's clock and its mounts since the last faster try
+static void sdcard_cid_keys(const sdmmc_cid_t* cid, char* clock_key, char* retry_key)
+{
+    uint32_t hash = crc32_le(0, (const uint8_t*)cid, sizeof(*cid));
+    sprintf(clock_key, "cid_%08x", hash);
+    sprintf(retry_key, "try_%08x", hash);
+}
+
+static int sdcard_setting_get(const char* key)
+{
+    nvs_handle handle;
+    if (nvs_open(SDCARD_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) return 0;
+
+    uint32_t value = 0;
+    if (nvs_get_u32(handle, key, &value) != ESP_OK) value = 0;
+
+    nvs_close(handle);
+    return (int)value;
+}
+
+static void sdcard_setting_set(const char* key, int value)
+{
+    nvs_handle handle;
+    esp_err_t err = nvs_open(SDCARD_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK)
+    {
+        err = nvs_set_u32(handle, key, (uint32_t)value);
+        if (err == ESP_OK) err = nvs_commit(handle);
+
+        nvs_close(handle);
+    }
+
+    if (err != ESP_OK)
+    {
+        printf("odroid_sdcard_open: saving '%s' failed (%d)\n", key, err);
+    }
+}
+
+static int sdcard_frequency_index(int freq_khz)
+{
+    for (int i = 0; i < FREQUENCY_COUNT; ++i)
+    {
+        if (frequencies[i] == freq_khz) return i;
+    }
+
+    return 0;
+}
+
+// Mounts at the fastest clock that passes the probe. The card is first
+// identified at the probing clock. A known card starts at the clock
+// recorded for it, and a new card at the fastest one. A failing clock steps
+// down and the record follows. Below the fastest clock, every
+// RETRY_FASTER_INTERVAL mounts start one step above the record instead.
 esp_err_t odroid_sdcard_open(const char* base_path)
 {
     esp_err_t ret;
@@ -180,53 +434,83 @@ esp_err_t odroid_sdcard_open(const char* base_path)
     if (isOpen)
     {
         printf("odroid_sdcard_open: alread open.\n");
-        ret = ESP_FAIL;
+        return ESP_FAIL;
     }
-    else
-    {
-        sdmmc_host_t host = SDSPI_HOST_DEFAULT();
-    	host.slot = HSPI_HOST; // HSPI_HOST;
-    	//host.max_freq_khz = SDMMC_FREQ_HIGHSPEED; //10000000;
-        host.max_freq_khz = SDMMC_FREQ_DEFAULT;
 
-    	sdspi_slot_config_t slot_config = SDSPI_SLOT_CONFIG_DEFAULT();
-    	slot_config.gpio_miso = (gpio_num_t)SD_PIN_NUM_MISO;
-    	slot_config.gpio_mosi = (gpio_num_t)SD_PIN_NUM_MOSI;
-    	slot_config.gpio_sck  = (gpio_num_t)SD_PIN_NUM_CLK;
-    	slot_config.gpio_cs = (gpio_num_t)SD_PIN_NUM_CS;
-    	//slot_config.dma_channel = 2;
+    odroid_spi_bus_init();
+
+    int step = 0;
+    char clockKey[16] = "";
+    char retryKey[16] = "";
 
-    	// Options for mounting the filesystem.
-    	// If format_if_mount_failed is set to true, SD card will be partitioned and
-    	// formatted in case when mounting fails.
-    	esp_vfs_fat_sdmmc_mount_config_t mount_config;
-        memset(&mount_config, 0, sizeof(mount_config));
+    sdmmc_cid_t cid;
+    if (sdcard_identify(&cid) == ESP_OK)
+    {
+        sdcard_cid_keys(&cid, clockKey, retryKey);
 
-    	mount_config.format_if_mount_failed = false;
-    	mount_config.max_files = 5;
+        int recorded = sdcard_setting_get(clockKey);
+        if (recorded) step = sdcard_frequency_index(recorded);
 
+        if (step > 0)
+        {
+            int mounts = sdcard_setting_get(retryKey) + 1;
+            if (mounts >= RETRY_FASTER_INTERVAL)
+            {
+                mounts = 0;
+                --step;
+                printf("odroid_sdcard_open: card last ran at %d kHz, trying %d kHz\n",
+                    recorded, frequencies[step]);
+            }
 
-    	// Use settings defined above to initialize SD card and mount FAT filesystem.
-    	// Note: esp_vfs_fat_sdmmc_mount is an all-in-one convenience function.
-    	// Please check its source code and implement error recovery when developing
-    	// production applications.
-    	sdmmc_card_t* card;
-    	ret = esp_vfs_fat_sdmmc_mount(base_path, &host, &slot_config, &mount_config, &card);
+            sdcard_setting_set(retryKey, mounts);
+        }
+    }
 
-    	if (ret == ESP_OK)
+    while (true)
+    {
+        ret = sdcard_mount(base_path, frequencies[step]);
+        if (ret == ESP_OK)
         {
-            isOpen = true;
+            int rate = sdcard_probe();
+            if (rate > 0)
+            {
+                printf("odroid_sdcard_open: %d kHz, probe read %d KB/s\n", frequencies[step], rate);
+                break;
+            }
+
+            if (step + 1 >= FREQUENCY_COUNT)
+            {
+                // Slowest clock; keep the mount and let file reads report errors
+                printf("odroid_sdcard_open: probe failed at the slowest clock\n");
+                break;
+            }
+
+            sdcard_unmount();
         }
-        else
+        else if (step + 1 >= FREQUENCY_COUNT)
         {
-            printf("odroid_sdcard_open: esp_vfs_fat_sdmmc_mount failed (%d)\n", ret);
+            return ret;
         }
+
+        ++step;
+    }
+
+    // Identification failed but the mount worked; the CID is known now
+    if (!clockKey[0]) sdcard_cid_keys(&card->cid, clockKey, retryKey);
+
+    if (sdcard_setting_get(clockKey) != frequencies[step])
+    {
+        sdcard_setting_set(clockKey, frequencies[step]);
+        if (step > 0) sdcard_setting_set(retryKey, 0);
     }
 
+    strncpy(basePath, base_path, sizeof(basePath) - 1);
+    basePath[sizeof(basePath) - 1] = 0;
+
+    isOpen = true;
 	return ret;
 }
 
-
 esp_err_t odroid_sdcard_close()
 {
     esp_err_t ret;
@@ -238,7 +522,14 @@ esp_err_t odroid_sdcard_close()
     }
     else
     {
+        odroid_sdcard_pool_flush();
+
+        odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
         ret = esp_vfs_fat_sdmmc_unmount();
+        odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+
+        card = NULL;
+        isOpen = false;
 
         if (ret != ESP_OK)
         {
@@ -260,61 +551,566 @@ size_t odroid_sdcard_get_filesize(const char* path)
     }
     else
     {
-        FILE* f = fopen(path, "rb");
-        if (f == NULL)
+        struct stat st;
+
+        odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+        int result = stat(path, &st);
+        odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+
+        if (result != 0)
         {
-            printf("odroid_sdcard_get_filesize: fopen failed.\n");
+            printf("odroid_sdcard_get_filesize: stat failed.\n");
         }
         else
         {
-            // get the file size
-            fseek(f, 0, SEEK_END);
-            ret = ftell(f);
-            fseek(f, 0, SEEK_SET);
+            ret = st.st_size;
         }
     }
 
     return ret;
 }
 
-size_t odroid_sdcard_copy_file_to_memory(const char* path, void* ptr)
+// Loads a whole file into 'ptr'. DMA-capable destinations are read into
+// directly; anything else (SPIRAM) is filled through a DMA bounce block,
+// since the SPI DMA can not write external RAM. Files larger than
+// 'capacity' are rejected rather than truncated.
+size_t odroid_sdcard_copy_file_to_memory(const char* path, void* ptr, size_t capacity)
 {
+    if (!isOpen)
+    {
+        printf("odroid_sdcard_copy_file_to_memory: not open.\n");
+        return 0;
+    }
+
+    if (!ptr)
+    {
+        printf("odroid_sdcard_copy_file_to_memory: ptr is null.\n");
+        return 0;
+    }
+
+    size_t size = odroid_sdcard_get_filesize(path);
+    if (size == 0) return 0;
+
+    if (size > capacity)
+    {
+        printf("odroid_sdcard_copy_file_to_memory: '%s' is %d bytes, capacity %d.\n",
+            path, (int)size, (int)capacity);
+        return 0;
+    }
+
+    uint8_t* bounce = NULL;
+    if (!esp_ptr_dma_capable(ptr))
+    {
+        bounce = odroid_sdcard_block_alloc(ODROID_SDCARD_BLOCK_SIZE_MIN);
+        if (!bounce)
+        {
+            printf("odroid_sdcard_copy_file_to_memory: bounce alloc failed.\n");
+            return 0;
+        }
+    }
+
+    odroid_sdcard_file* file = odroid_sdcard_file_open(path);
+    if (!file)
+    {
+        free(bounce);
+        return 0;
+    }
+
+    int64_t start = esp_timer_get_time();
     size_t ret = 0;
 
+    while (ret < size)
+    {
+        size_t length = size - ret;
+        ssize_t count;
+
+        if (bounce)
+        {
+            if (length > ODROID_SDCARD_BLOCK_SIZE_MIN) length = ODROID_SDCARD_BLOCK_SIZE_MIN;
+
+            count = odroid_sdcard_file_read(file, bounce, length);
+            if (count > 0) memcpy((uint8_t*)ptr + ret, bounce, count);
+        }
+        else
+        {
+            count = odroid_sdcard_file_read(file, (uint8_t*)ptr + ret, length);
+        }
+
+        if (count <= 0) break;
+
+        ret += count;
+    }
+
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    odroid_sdcard_file_close(file);
+    free(bounce);
+
+    if (ret != size)
+    {
+        printf("odroid_sdcard_copy_file_to_memory: short read %d of %d bytes.\n", (int)ret, (int)size);
+        return 0;
+    }
+
+    if (elapsed < 1) elapsed = 1;
+    printf("odroid_sdcard_copy_file_to_memory: %d bytes in %d ms, %d KB/s%s\n",
+        (int)ret, (int)(elapsed / 1000), (int)((ret * 1000000LL / 1024) / elapsed),
+        bounce ? " (bounced)" : "");
+
+    return ret;
+}
+
+
+void* odroid_sdcard_block_alloc(size_t size)
+{
+    if (size < 512 || (size % 512) != 0 || size > ODROID_SDCARD_BLOCK_SIZE_MAX)
+    {
+        printf("odroid_sdcard_block_alloc: invalid size %d.\n", (int)size);
+        return NULL;
+    }
+
+    return heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+}
+
+// Reads until 'length' bytes or end of file. The bus is held per read()
+// so the LCD can update between blocks.
+ssize_t odroid_sdcard_read(int fd, void* buffer, size_t length)
+{
+    size_t total = 0;
+
+    while (total < length)
+    {
+        odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+        ssize_t count = read(fd, (uint8_t*)buffer + total, length - total);
+        odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+
+        if (count < 0)
+        {
+            printf("odroid_sdcard_read: read failed (%d).\n", errno);
+            return -1;
+        }
+
+        if (count == 0) break;
+
+        total += count;
+    }
+
+    return total;
+}
+
+// Sequential read rate of a file in KB/s using 'block_size' reads, over at
+// most 'max_length' bytes. Returns -1 on error.
+int odroid_sdcard_read_rate(const char* path, size_t block_size, size_t max_length)
+{
     if (!isOpen)
     {
-        printf("odroid_sdcard_copy_file_to_memory: not open.\n");
+        printf("odroid_sdcard_read_rate: not open.\n");
+        return -1;
     }
-    else
+
+    void* buffer = odroid_sdcard_block_alloc(block_size);
+    if (!buffer) return -1;
+
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+    int fd = open(path, O_RDONLY);
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+
+    if (fd < 0)
+    {
+        printf("odroid_sdcard_read_rate: open failed.\n");
+        free(buffer);
+        return -1;
+    }
+
+    size_t total = 0;
+    int64_t start = esp_timer_get_time();
+
+    while (total < max_length)
+    {
+        ssize_t count = odroid_sdcard_read(fd, buffer, block_size);
+        if (count <= 0) break;
+
+        total += count;
+    }
+
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+    close(fd);
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+
+    free(buffer);
+
+    if (total == 0 || elapsed < 1) return -1;
+
+    int rate = (int)((total * 1000000LL / 1024) / elapsed);
+    printf("odroid_sdcard_read_rate: block=%d, bytes=%d, %d KB/s\n", (int)block_size, (int)total, rate);
+
+    return rate;
+}
+
+
+// Asks FATFS for the file's cluster chain and reports the first sector if
+// the clusters are consecutive. Called with the bus held.
+static bool sdcard_file_extent(const char* path, uint32_t* out_sector, size_t* out_size)
+{
+    const size_t baseLength = strlen(basePath);
+    if (strncmp(path, basePath, baseLength) != 0) return false;
+
+    char fatPath[256];
+    if (snprintf(fatPath, sizeof(fatPath), SDCARD_FAT_DRIVE "%s", path + baseLength) >= sizeof(fatPath))
+        return false;
+
+    FIL fil;
+    if (f_open(&fil, fatPath, FA_READ) != FR_OK) return false;
+
+    FATFS* fs = fil.obj.fs;
+    const DWORD start = fil.obj.sclust;
+    const FSIZE_t size = f_size(&fil);
+
+    bool contiguous = (start >= 2 && size > 0);
+#if _MAX_SS != _MIN_SS
+    if (fs->ssize != SDCARD_SECTOR_SIZE) contiguous = false;
+#endif
+
+    const DWORD clusterBytes = (DWORD)fs->csize * SDCARD_SECTOR_SIZE;
+    for (FSIZE_t offset = clusterBytes; contiguous && offset < size; offset += clusterBytes)
+    {
+        // f_lseek leaves clust on the cluster holding the byte before the
+        // new position, so step one byte past each cluster boundary.
+        if (f_lseek(&fil, offset + 1) != FR_OK ||
+            fil.clust != start + (offset / clusterBytes))
+        {
+            contiguous = false;
+        }
+    }
+
+    *out_sector = fs->database + (start - 2) * fs->csize;
+    *out_size = size;
+
+    f_close(&fil);
+
+    return contiguous;
+}
+
+odroid_sdcard_file* odroid_sdcard_file_open(const char* path)
+{
+    if (!isOpen)
+    {
+        printf("odroid_sdcard_file_open: not open.\n");
+        return NULL;
+    }
+
+    odroid_sdcard_file* file = calloc(1, sizeof(odroid_sdcard_file));
+    if (!file) return NULL;
+
+    file->fd = -1;
+
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+
+    file->contiguous = sdcard_file_extent(path, &file->first_sector, &file->size);
+    if (file->contiguous)
+    {
+        file->sector = heap_caps_malloc(SDCARD_SECTOR_SIZE, MALLOC_CAP_DMA);
+        file->sector_lba = UINT32_MAX;
+
+        if (!file->sector) file->contiguous = false;
+    }
+
+    if (!file->contiguous)
+    {
+        file->fd = open(path, O_RDONLY);
+    }
+
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+
+    if (!file->contiguous && file->fd < 0)
+    {
+        printf("odroid_sdcard_file_open: open failed '%s'.\n", path);
+        free(file);
+        return NULL;
+    }
+
+    printf("odroid_sdcard_file_open: '%s' %s\n", path,
+        file->contiguous ? "contiguous, raw sector reads" : "fragmented, VFS reads");
+
+    return file;
+}
+
+bool odroid_sdcard_file_is_contiguous(const odroid_sdcard_file* file)
+{
+    return file->contiguous;
+}
+
+// Whole sectors go straight from the card into 'buffer'; only a partial
+// sector at either end is staged.
+ssize_t odroid_sdcard_file_read(odroid_sdcard_file* file, void* buffer, size_t length)
+{
+    if (!file->contiguous) return odroid_sdcard_read(file->fd, buffer, length);
+
+    if (file->position >= file->size) return 0;
+    if (length > file->size - file->position) length = file->size - file->position;
+
+    uint8_t* dest = (uint8_t*)buffer;
+    size_t remaining = length;
+
+    while (remaining > 0)
     {
-        if (!ptr)
+        const uint32_t lba = file->first_sector + (file->position / SDCARD_SECTOR_SIZE);
+        const size_t skip = file->position % SDCARD_SECTOR_SIZE;
+        size_t count;
+        esp_err_t ret = ESP_OK;
+
+        odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+
+        if (skip == 0 && remaining >= SDCARD_SECTOR_SIZE)
         {
-            printf("odroid_sdcard_copy_file_to_memory: ptr is null.\n");
+            // Bounded so the LCD gets the bus between bursts
+            size_t sectors = remaining / SDCARD_SECTOR_SIZE;
+            if (sectors > ODROID_SDCARD_BLOCK_SIZE_MAX / SDCARD_SECTOR_SIZE)
+                sectors = ODROID_SDCARD_BLOCK_SIZE_MAX / SDCARD_SECTOR_SIZE;
+
+            ret = sdmmc_read_sectors(card, dest, lba, sectors);
+            count = sectors * SDCARD_SECTOR_SIZE;
         }
         else
         {
-            FILE* f = fopen(path, "rb");
-            if (f == NULL)
+            if (file->sector_lba != lba)
             {
-                printf("odroid_sdcard_copy_file_to_memory: fopen failed.\n");
+                ret = sdmmc_read_sectors(card, file->sector, lba, 1);
+                file->sector_lba = (ret == ESP_OK) ? lba : UINT32_MAX;
             }
-            else
-            {
-                // copy
-                const size_t BLOCK_SIZE = 512;
-                while(true)
-                {
-                    __asm__("memw");
-                    size_t count = fread((uint8_t*)ptr + ret, 1, BLOCK_SIZE, f);
-                    __asm__("memw");
 
-                    ret += count;
+            count = SDCARD_SECTOR_SIZE - skip;
+            if (count > remaining) count = remaining;
 
-                    if (count < BLOCK_SIZE) break;
-                }
+            if (ret == ESP_OK) memcpy(dest, file->sector + skip, count);
+        }
+
+        odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+
+        if (ret != ESP_OK)
+        {
+            printf("odroid_sdcard_file_read: sdmmc_read_sectors failed at %u (%d).\n", lba, ret);
+            return -1;
+        }
+
+        dest += count;
+        remaining -= count;
+        file->position += count;
+    }
+
+    return length;
+}
+
+off_t odroid_sdcard_file_seek(odroid_sdcard_file* file, off_t offset, int whence)
+{
+    if (!file->contiguous)
+    {
+        odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+        off_t result = lseek(file->fd, offset, whence);
+        odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+
+        return result;
+    }
+
+    off_t position;
+    switch (whence)
+    {
+        case SEEK_SET: position = offset; break;
+        case SEEK_CUR: position = (off_t)file->position + offset; break;
+        case SEEK_END: position = (off_t)file->size + offset; break;
+        default: return -1;
+    }
+
+    if (position < 0) return -1;
+
+    file->position = position;
+    return position;
+}
+
+void odroid_sdcard_file_close(odroid_sdcard_file* file)
+{
+    if (!file) return;
+
+    if (file->fd >= 0)
+    {
+        odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+        close(file->fd);
+        odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+    }
+
+    free(file->sector);
+    free(file);
+}
+
+
+// Pool state is guarded by the bus lock, which every caller needs for the
+// file operations anyway.
+static void pool_close(pool_entry* entry)
+{
+    fclose(entry->file);
+    free(entry->path);
+    memset(entry, 0, sizeof(*entry));
+
+    ++poolStats.closes;
+    --poolStats.open_now;
+}
+
+// Closes idle handles, oldest first, until at most 'limit' are open
+static void pool_trim(int limit)
+{
+    while (poolStats.open_now > limit)
+    {
+        pool_entry* oldest = NULL;
+        for (int i = 0; i < POOL_CAP_MAX; ++i)
+        {
+            if (pool[i].file && !pool[i].in_use &&
+                (!oldest || pool[i].last_used < oldest->last_used))
+            {
+                oldest = &pool[i];
             }
         }
+
+        if (!oldest) break;
+
+        pool_close(oldest);
+        ++poolStats.evictions;
     }
+}
 
-    return ret;
+FILE* odroid_sdcard_pool_open(const char* path)
+{
+    FILE* result = NULL;
+
+    if (!isOpen)
+    {
+        printf("odroid_sdcard_pool_open: not open.\n");
+        return NULL;
+    }
+
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+
+    for (int i = 0; i < POOL_CAP_MAX; ++i)
+    {
+        if (pool[i].file && !pool[i].in_use && strcmp(pool[i].path, path) == 0 &&
+            fseek(pool[i].file, 0, SEEK_SET) == 0)
+        {
+            pool[i].in_use = true;
+            pool[i].last_used = ++poolClock;
+            ++poolStats.reuses;
+
+            result = pool[i].file;
+            goto odroid_sdcard_pool_open_exit;
+        }
+    }
+
+    pool_trim(poolCap - 1);
+
+    pool_entry* entry = NULL;
+    for (int i = 0; i < POOL_CAP_MAX; ++i)
+    {
+        if (!pool[i].file)
+        {
+            entry = &pool[i];
+            break;
+        }
+    }
+
+    if (!entry || poolStats.open_now >= poolCap)
+    {
+        printf("odroid_sdcard_pool_open: all %d handles in use.\n", poolCap);
+        goto odroid_sdcard_pool_open_exit;
+    }
+
+    entry->path = strdup(path);
+    if (!entry->path) goto odroid_sdcard_pool_open_exit;
+
+    entry->file = fopen(path, "rb");
+    if (!entry->file)
+    {
+        free(entry->path);
+        entry->path = NULL;
+        goto odroid_sdcard_pool_open_exit;
+    }
+
+    entry->in_use = true;
+    entry->last_used = ++poolClock;
+    ++poolStats.opens;
+    ++poolStats.open_now;
+
+    result = entry->file;
+
+odroid_sdcard_pool_open_exit:
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+
+    return result;
+}
+
+void odroid_sdcard_pool_release(FILE* file)
+{
+    if (!file) return;
+
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+
+    for (int i = 0; i < POOL_CAP_MAX; ++i)
+    {
+        if (pool[i].file == file)
+        {
+            pool[i].in_use = false;
+            pool_trim(poolCap);
+
+            odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+            return;
+        }
+    }
+
+    printf("odroid_sdcard_pool_release: unknown file %p.\n", file);
+    abort();
+}
+
+void odroid_sdcard_pool_set_cap(int cap)
+{
+    if (cap < 1 || cap > POOL_CAP_MAX)
+    {
+        printf("odroid_sdcard_pool_set_cap: cap %d out of range 1-%d.\n", cap, POOL_CAP_MAX);
+        abort();
+    }
+
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+
+    poolCap = cap;
+    pool_trim(poolCap);
+
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+}
+
+void odroid_sdcard_pool_flush()
+{
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+
+    for (int i = 0; i < POOL_CAP_MAX; ++i)
+    {
+        if (!pool[i].file) continue;
+
+        if (pool[i].in_use)
+        {
+            printf("odroid_sdcard_pool_flush: '%s' still in use.\n", pool[i].path);
+            abort();
+        }
+
+        pool_close(&pool[i]);
+    }
+
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
+}
+
+void odroid_sdcard_pool_stats_get(odroid_sdcard_pool_stats* out_stats)
+{
+    odroid_spi_bus_acquire(ODROID_SPI_DEVICE_SDCARD);
+
+    *out_stats = poolStats;
+    out_stats->cap = poolCap;
+
+    odroid_spi_bus_release(ODROID_SPI_DEVICE_SDCARD);
 }
@@ -2,9 +2,67 @@
 
 #include "esp_err.h"
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+
+// Bulk reads go through POSIX read() straight into DMA-capable buffers so
+// FATFS can transfer whole sectors without stdio staging. Bulk transfers
+// use a block size within this range; any multiple of the 512 byte sector
+// up to the maximum is accepted so smaller sizes can be measured.
+#define ODROID_SDCARD_BLOCK_SIZE_MIN (32 * 1024)
+#define ODROID_SDCARD_BLOCK_SIZE_MAX (64 * 1024)
+
+// Files the mount can hold open at once. The VFS allocates every FIL up
+// front and each carries a sector sized cache (4 KB with the wear levelling
+// sector size), so this stays modest. The handle pool below may use all
+// but ODROID_SDCARD_POOL_RESERVE of them; the default cap covers one
+// browser page of tiles.
+#define ODROID_SDCARD_MAX_FILES (10)
+#define ODROID_SDCARD_POOL_RESERVE (4)
+#define ODROID_SDCARD_POOL_DEFAULT_CAP (4)
+
 int odroid_sdcard_files_get(const char* path, const char* extension, char*** filesOut);
 void odroid_sdcard_files_free(char** files, int count);
 esp_err_t odroid_sdcard_open();
 esp_err_t odroid_sdcard_close();
 size_t odroid_sdcard_get_filesize(const char* path);
-size_t odroid_sdcard_copy_file_to_memory(const char* path, void* ptr);
+size_t odroid_sdcard_copy_file_to_memory(const char* path, void* ptr, size_t capacity);
+
+void* odroid_sdcard_block_alloc(size_t size);
+ssize_t odroid_sdcard_read(int fd, void* buffer, size_t length);
+int odroid_sdcard_read_rate(const char* path, size_t block_size, size_t max_length);
+
+// Files stored in consecutive clusters are read with raw multi-sector
+// transfers, bypassing the VFS and FATFS buffering; anything else falls
+// back to the VFS.
+typedef struct odroid_sdcard_file odroid_sdcard_file;
+
+odroid_sdcard_file* odroid_sdcard_file_open(const char* path);
+bool odroid_sdcard_file_is_contiguous(const odroid_sdcard_file* file);
+ssize_t odroid_sdcard_file_read(odroid_sdcard_file* file, void* buffer, size_t length);
+off_t odroid_sdcard_file_seek(odroid_sdcard_file* file, off_t offset, int whence);
+void odroid_sdcard_file_close(odroid_sdcard_file* file);
+
+// Read-only stdio handles kept open between uses, keyed by path, so
+// repeated reads of the same files (browser redraws) skip the FATFS open
+// and the stdio buffer allocation. Idle handles are closed least recently
+// used first once the cap is reached, and all of them on close.
+typedef struct
+{
+    uint32_t opens;     // new handles
+    uint32_t reuses;    // requests served by an idle handle
+    uint32_t closes;
+    uint32_t evictions; // closes made to stay under the cap
+    int open_now;
+    int cap;
+} odroid_sdcard_pool_stats;
+
+FILE* odroid_sdcard_pool_open(const char* path);
+void odroid_sdcard_pool_release(FILE* file);
+void odroid_sdcard_pool_set_cap(int cap);
+void odroid_sdcard_pool_flush();
+void odroid_sdcard_pool_stats_get(odroid_sdcard_pool_stats* out_stats);
@@ -0,0 +1,109 @@
+#include "odroid_spi_bus.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+#define MAX_DEPTH (8)
+
+// Nested acquisitions by the holding task (for example an error message
+// drawn in the middle of an SD burst) charge time to the innermost device.
+static SemaphoreHandle_t bus_mutex;
+static odroid_spi_device owners[MAX_DEPTH];
+static int depth;
+static int64_t owner_since;
+static odroid_spi_bus_stats stats[ODROID_SPI_DEVICE_MAX];
+
+static const char* device_names[ODROID_SPI_DEVICE_MAX] = { "LCD", "SD" };
+
+
+void odroid_spi_bus_init()
+{
+    if (bus_mutex) return;
+
+    bus_mutex = xSemaphoreCreateRecursiveMutex();
+    if (!bus_mutex)
+    {
+        printf("%s: xSemaphoreCreateRecursiveMutex failed.\n", __func__);
+        abort();
+    }
+}
+
+void odroid_spi_bus_acquire(odroid_spi_device device)
+{
+    if (!bus_mutex) abort();
+    if (device >= ODROID_SPI_DEVICE_MAX) abort();
+
+    int64_t start = esp_timer_get_time();
+
+    xSemaphoreTakeRecursive(bus_mutex, portMAX_DELAY);
+
+    if (depth >= MAX_DEPTH) abort();
+
+    int64_t now = esp_timer_get_time();
+
+    if (depth == 0)
+    {
+        stats[device].wait_us += now - start;
+    }
+    else if (owners[depth - 1] != device)
+    {
+        stats[owners[depth - 1]].busy_us += now - owner_since;
+    }
+
+    if (depth == 0 || owners[depth - 1] != device)
+    {
+        stats[device].acquisitions++;
+        owner_since = now;
+    }
+
+    owners[depth++] = device;
+}
+
+void odroid_spi_bus_release(odroid_spi_device device)
+{
+    if (depth < 1 || owners[depth - 1] != device) abort();
+
+    --depth;
+
+    if (depth == 0 || owners[depth - 1] != device)
+    {
+        int64_t now = esp_timer_get_time();
+        stats[device].busy_us += now - owner_since;
+        owner_since = now;
+    }
+
+    xSemaphoreGiveRecursive(bus_mutex);
+}
+
+void odroid_spi_bus_stats_get(odroid_spi_device device, odroid_spi_bus_stats* out_stats)
+{
+    if (device >= ODROID_SPI_DEVICE_MAX) abort();
+
+    xSemaphoreTakeRecursive(bus_mutex, portMAX_DELAY);
+    *out_stats = stats[device];
+    xSemaphoreGiveRecursive(bus_mutex);
+}
+
+void odroid_spi_bus_stats_reset()
+{
+    xSemaphoreTakeRecursive(bus_mutex, portMAX_DELAY);
+    memset(stats, 0, sizeof(stats));
+    xSemaphoreGiveRecursive(bus_mutex);
+}
+
+void odroid_spi_bus_stats_print()
+{
+    for (int i = 0; i < ODROID_SPI_DEVICE_MAX; ++i)
+    {
+        odroid_spi_bus_stats s;
+        odroid_spi_bus_stats_get(i, &s);
+
+        printf("SPI bus %s: acquisitions=%u, busy=%d ms, wait=%d ms\n",
+            device_names[i], (unsigned)s.acquisitions, (int)(s.busy_us / 1000), (int)(s.wait_us / 1000));
+    }
+}
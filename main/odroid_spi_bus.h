@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+
+// The LCD and the SD card share HSPI_HOST (MISO/MOSI/CLK). spi_master
+// switches clock and chip select per device, but a multi-transaction
+// operation such as a frame push or an SD read burst must not be split
+// by the other device. Holders take the bus for a whole burst.
+typedef enum
+{
+    ODROID_SPI_DEVICE_LCD = 0,
+    ODROID_SPI_DEVICE_SDCARD,
+
+    ODROID_SPI_DEVICE_MAX
+} odroid_spi_device;
+
+typedef struct
+{
+    uint32_t acquisitions;
+    int64_t busy_us;
+    int64_t wait_us;
+} odroid_spi_bus_stats;
+
+
+void odroid_spi_bus_init();
+void odroid_spi_bus_acquire(odroid_spi_device device);
+void odroid_spi_bus_release(odroid_spi_device device);
+
+void odroid_spi_bus_stats_get(odroid_spi_device device, odroid_spi_bus_stats* out_stats);
+void odroid_spi_bus_stats_reset();
+void odroid_spi_bus_stats_print();
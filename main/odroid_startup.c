@@ -0,0 +1,116 @@
+#include "odroid_startup.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+#define STAGE_STACK_SIZE (4096)
+
+typedef struct
+{
+    const odroid_startup_stage* stage;
+    int index;
+    esp_err_t result;
+    int64_t start_us;
+    int64_t end_us;
+    int core;
+} stage_record;
+
+static EventGroupHandle_t done_bits;
+static stage_record records[ODROID_STARTUP_STAGE_MAX];
+static int record_count;
+
+
+static void stage_task(void* arg)
+{
+    stage_record* record = (stage_record*)arg;
+
+    if (record->stage->depends)
+    {
+        xEventGroupWaitBits(done_bits, record->stage->depends, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+
+    record->core = xPortGetCoreID();
+    record->start_us = esp_timer_get_time();
+    record->result = record->stage->run();
+    record->end_us = esp_timer_get_time();
+
+    xEventGroupSetBits(done_bits, ODROID_STARTUP_DEPENDS(record->index));
+
+    vTaskDelete(NULL);
+}
+
+static void print_timeline(int64_t origin)
+{
+    printf("startup timeline (ms since power on, run started at %d):\n", (int)(origin / 1000));
+
+    for (int i = 0; i < record_count; ++i)
+    {
+        const stage_record* record = &records[i];
+        printf("  %-10s core %d  start %5d  end %5d  took %4d%s\n",
+            record->stage->name, record->core,
+            (int)(record->start_us / 1000), (int)(record->end_us / 1000),
+            (int)((record->end_us - record->start_us) / 1000),
+            (record->result == ESP_OK) ? "" : "  FAILED");
+    }
+}
+
+void odroid_startup_run(const odroid_startup_stage* stages, int count)
+{
+    if (count < 1 || count > ODROID_STARTUP_STAGE_MAX) abort();
+
+    // Dependencies may only point backwards so the graph can not cycle
+    for (int i = 0; i < count; ++i)
+    {
+        if (stages[i].depends & ~(ODROID_STARTUP_DEPENDS(i) - 1))
+        {
+            printf("%s: stage '%s' depends on a later stage.\n", __func__, stages[i].name);
+            abort();
+        }
+    }
+
+    if (!done_bits)
+    {
+        done_bits = xEventGroupCreate();
+        if (!done_bits) abort();
+    }
+
+    xEventGroupClearBits(done_bits, ODROID_STARTUP_DEPENDS(ODROID_STARTUP_STAGE_MAX) - 1);
+
+    memset(records, 0, sizeof(records));
+    record_count = count;
+
+    int64_t origin = esp_timer_get_time();
+    UBaseType_t priority = uxTaskPriorityGet(NULL);
+
+    for (int i = 0; i < count; ++i)
+    {
+        records[i].stage = &stages[i];
+        records[i].index = i;
+        records[i].result = ESP_FAIL;
+
+        BaseType_t ret = xTaskCreatePinnedToCore(&stage_task, stages[i].name, STAGE_STACK_SIZE,
+            &records[i], priority, NULL, stages[i].core);
+        if (ret != pdPASS)
+        {
+            printf("%s: xTaskCreatePinnedToCore failed for '%s'.\n", __func__, stages[i].name);
+            abort();
+        }
+    }
+
+    xEventGroupWaitBits(done_bits, ODROID_STARTUP_DEPENDS(count) - 1, pdFALSE, pdTRUE, portMAX_DELAY);
+
+    print_timeline(origin);
+}
+
+esp_err_t odroid_startup_result(int stage)
+{
+    if (stage < 0 || stage >= record_count) abort();
+
+    return records[stage].result;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+
+// Runs initialisers as tasks. Each stage starts once every stage in its
+// 'depends' mask (bit n = stage n) has finished, so independent stages
+// overlap across both cores. A failed stage still counts as finished;
+// callers check the result with odroid_startup_result.
+typedef struct
+{
+    const char* name;
+    esp_err_t (*run)();
+    uint32_t depends;
+    int core;
+} odroid_startup_stage;
+
+#define ODROID_STARTUP_STAGE_MAX (16)
+#define ODROID_STARTUP_DEPENDS(stage) (1u << (stage))
+
+
+// Blocks until every stage has run, then prints a timeline
+void odroid_startup_run(const odroid_startup_stage* stages, int count);
+esp_err_t odroid_startup_result(int stage);
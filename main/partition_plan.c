@@ -0,0 +1,198 @@
+#include "partition_plan.h"
+
+#include <string.h>
+
+
+static uint32_t align_up(uint32_t value)
+{
+    return (value + PARTITION_PLAN_ALIGN - 1) & ~(PARTITION_PLAN_ALIGN - 1);
+}
+
+static bool same_partition(const partition_plan_entry_t* a, const partition_plan_entry_t* b)
+{
+    return a->type == b->type &&
+        a->subtype == b->subtype &&
+        a->size == b->size &&
+        strncmp((const char*)a->label, (const char*)b->label, PARTITION_PLAN_LABEL_LENGTH) == 0;
+}
+
+static bool overlaps(uint32_t offset, uint32_t size, const partition_plan_entry_t* entry)
+{
+    uint32_t end = entry->offset + align_up(entry->size);
+    return offset < end && entry->offset < offset + size;
+}
+
+// Lowest aligned offset in the region where 'size' bytes do not overlap any
+// placed partition. Candidates are the region start and the end of each
+// placed partition.
+static bool find_gap(const partition_plan_entry_t* incoming, const bool* placed, int count,
+    uint32_t size, uint32_t region_start, uint32_t region_end, uint32_t* out_offset)
+{
+    bool found = false;
+    uint32_t best = 0;
+
+    for (int c = -1; c < count; ++c)
+    {
+        uint32_t candidate;
+        if (c < 0)
+        {
+            candidate = region_start;
+        }
+        else
+        {
+            if (!placed[c]) continue;
+            candidate = incoming[c].offset + align_up(incoming[c].size);
+        }
+
+        candidate = align_up(candidate);
+        if (candidate < region_start || candidate + size > region_end || candidate + size < candidate) continue;
+        if (found && candidate >= best) continue;
+
+        bool clear = true;
+        for (int i = 0; i < count; ++i)
+        {
+            if (placed[i] && overlaps(candidate, size, &incoming[i]))
+            {
+                clear = false;
+                break;
+            }
+        }
+
+        if (clear)
+        {
+            best = candidate;
+            found = true;
+        }
+    }
+
+    if (found) *out_offset = best;
+    return found;
+}
+
+static void mark_kept(const partition_plan_entry_t* current, int current_count,
+    const partition_plan_entry_t* incoming, bool* out_kept, int incoming_count)
+{
+    for (int i = 0; i < incoming_count; ++i)
+    {
+        out_kept[i] = false;
+        for (int j = 0; j < current_count; ++j)
+        {
+            if (current[j].offset == incoming[i].offset && same_partition(&current[j], &incoming[i]))
+            {
+                out_kept[i] = true;
+                break;
+            }
+        }
+    }
+}
+
+static int count_kept(const bool* kept, int count)
+{
+    int result = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (kept[i]) ++result;
+    }
+
+    return result;
+}
+
+static bool pack(partition_plan_entry_t* incoming, int incoming_count,
+    uint32_t region_start, uint32_t region_end)
+{
+    uint32_t offset = align_up(region_start);
+    for (int i = 0; i < incoming_count; ++i)
+    {
+        uint32_t size = align_up(incoming[i].size);
+        if (offset < region_start || size > region_end - offset || offset > region_end) return false;
+
+        incoming[i].offset = offset;
+        offset += size;
+    }
+
+    return true;
+}
+
+int partition_plan_layout(const partition_plan_entry_t* current, int current_count,
+    partition_plan_entry_t* incoming, bool* out_kept, int incoming_count,
+    uint32_t region_start, uint32_t region_end)
+{
+    bool placed[incoming_count > 0 ? incoming_count : 1];
+    bool claimed[current_count > 0 ? current_count : 1];
+
+    memset(placed, 0, sizeof(placed));
+    memset(claimed, 0, sizeof(claimed));
+
+    // Keep identical partitions where they are
+    for (int i = 0; i < incoming_count; ++i)
+    {
+        for (int j = 0; j < current_count; ++j)
+        {
+            const partition_plan_entry_t* old = &current[j];
+            if (claimed[j] || !same_partition(old, &incoming[i])) continue;
+            if (old->offset < region_start || old->offset != align_up(old->offset)) continue;
+            if (old->offset + align_up(old->size) > region_end) continue;
+
+            incoming[i].offset = old->offset;
+            placed[i] = true;
+            claimed[j] = true;
+            break;
+        }
+    }
+
+    // Everything else goes into the lowest gap that fits, in file order
+    bool fits = true;
+    for (int i = 0; i < incoming_count && fits; ++i)
+    {
+        if (placed[i]) continue;
+
+        fits = find_gap(incoming, placed, incoming_count, align_up(incoming[i].size),
+            region_start, region_end, &incoming[i].offset);
+        placed[i] = fits;
+    }
+
+    if (!fits && !pack(incoming, incoming_count, region_start, region_end))
+    {
+        return -1;
+    }
+
+    mark_kept(current, current_count, incoming, out_kept, incoming_count);
+    return count_kept(out_kept, incoming_count);
+}
+
+int partition_plan_erase_ranges(const bool* differs, int count, partition_plan_range_t* out_ranges)
+{
+    int differing = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (differs[i]) ++differing;
+    }
+
+    if (differing == 0) return 0;
+
+    if (differing * 2 > count)
+    {
+        out_ranges[0].first = 0;
+        out_ranges[0].count = count;
+        return 1;
+    }
+
+    int result = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (!differs[i]) continue;
+
+        if (result > 0 && out_ranges[result - 1].first + out_ranges[result - 1].count == i)
+        {
+            ++out_ranges[result - 1].count;
+        }
+        else
+        {
+            out_ranges[result].first = i;
+            out_ranges[result].count = 1;
+            ++result;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Placement of firmware partitions behind the factory app. Partitions that
+// already exist with the same type, subtype, label and size stay at their
+// current offsets; the rest go into 64 KB aligned gaps. Kept free of
+// ESP-IDF dependencies so synthetic tables can be planned on a host.
+
+#define PARTITION_PLAN_ALIGN (0x10000)
+#define PARTITION_PLAN_LABEL_LENGTH (16)
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t subtype;
+    uint8_t label[PARTITION_PLAN_LABEL_LENGTH]; // not necessarily null terminated
+    uint32_t offset;
+    uint32_t size;
+} partition_plan_entry_t;
+
+// Run of sectors, in sector indices
+typedef struct
+{
+    int first;
+    int count;
+} partition_plan_range_t;
+
+
+// current: the existing partitions in [region_start, region_end).
+// incoming: offset is filled in. out_kept[i] is set when incoming[i] sits
+// exactly where an identical partition already is, so its sectors may
+// already hold the right data.
+// Falls back to packing everything contiguously from region_start (the
+// old layout) when the gaps are too fragmented. Returns the number of kept
+// partitions, or -1 if the partitions do not fit at all.
+int partition_plan_layout(const partition_plan_entry_t* current, int current_count,
+    partition_plan_entry_t* incoming, bool* out_kept, int incoming_count,
+    uint32_t region_start, uint32_t region_end);
+
+// Erase plan for a block of 'count' sectors in a kept partition, where
+// differs[i] is set when sector i does not hold the new data. Adjacent
+// differing sectors merge into one range, and when most sectors differ the
+// whole block becomes a single range (its unchanged sectors are rewritten).
+// Returns the number of ranges; out_ranges needs room for (count + 1) / 2.
+int partition_plan_erase_ranges(const bool* differs, int count, partition_plan_range_t* out_ranges);
@@ -0,0 +1,159 @@
+#include "partition_table.h"
+
+#include <string.h>
+
+
+static uint16_t read16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t read32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Raw entry layout: magic(2) type(1) subtype(1) offset(4) size(4) label(16) flags(4)
+static void decode_entry(const uint8_t* raw, int index, partition_table_entry_t* out)
+{
+    memset(out, 0, sizeof(*out));
+    out->type = raw[2];
+    out->subtype = raw[3];
+    out->offset = read32(raw + 4);
+    out->size = read32(raw + 8);
+    memcpy(out->label, raw + 12, PARTITION_TABLE_LABEL_LENGTH);
+    out->flags = read32(raw + 28);
+    out->index = index;
+}
+
+partition_table_result_t partition_table_parse(partition_table_t* table, const void* raw, size_t length,
+    partition_table_md5_fn md5)
+{
+    memset(table, 0, sizeof(*table));
+
+    if (length < PARTITION_TABLE_ENTRY_SIZE || length > PARTITION_TABLE_MAX_LEN)
+        return PARTITION_TABLE_ERR_LENGTH;
+
+    memset(table->raw, 0xff, sizeof(table->raw));
+    memcpy(table->raw, raw, length);
+
+    for (int i = 0; i < PARTITION_TABLE_MAX_ENTRIES; ++i)
+    {
+        const uint8_t* entry = table->raw + i * PARTITION_TABLE_ENTRY_SIZE;
+        uint16_t magic = read16(entry);
+
+        if (magic == 0xffff) break;
+
+        if (magic == PARTITION_TABLE_MAGIC_MD5)
+        {
+            // 14 bytes of padding, then the digest of everything before it
+            table->has_md5 = true;
+            if (md5)
+            {
+                uint8_t digest[16];
+                md5(table->raw, i * PARTITION_TABLE_ENTRY_SIZE, digest);
+                if (memcmp(digest, entry + 16, sizeof(digest)) != 0) return PARTITION_TABLE_ERR_MD5;
+            }
+            break;
+        }
+
+        if (magic != PARTITION_TABLE_MAGIC) return PARTITION_TABLE_ERR_MAGIC;
+
+        decode_entry(entry, i, &table->entries[table->count++]);
+    }
+
+    for (int i = 0; i < table->count; ++i)
+    {
+        const partition_table_entry_t* a = &table->entries[i];
+        for (int j = i + 1; j < table->count; ++j)
+        {
+            const partition_table_entry_t* b = &table->entries[j];
+            if (a->offset < b->offset + b->size && b->offset < a->offset + a->size)
+                return PARTITION_TABLE_ERR_OVERLAP;
+        }
+    }
+
+    return PARTITION_TABLE_OK;
+}
+
+const partition_table_entry_t* partition_table_find(const partition_table_t* table,
+    int type, int subtype, const char* label)
+{
+    for (int i = 0; i < table->count; ++i)
+    {
+        const partition_table_entry_t* entry = &table->entries[i];
+
+        if (type != PARTITION_TABLE_ANY && entry->type != type) continue;
+        if (subtype != PARTITION_TABLE_ANY && entry->subtype != subtype) continue;
+        if (label && strncmp(entry->label, label, PARTITION_TABLE_LABEL_LENGTH) != 0) continue;
+
+        return entry;
+    }
+
+    return NULL;
+}
+
+// Reports each gap to out_gaps (optional) and the largest to out_largest
+static int free_space_walk(const partition_table_t* table, uint32_t start, uint32_t end,
+    uint32_t align, partition_table_gap_t* out_gaps, int max_gaps, uint32_t* out_largest)
+{
+    if (align == 0) align = 1;
+
+    int count = 0;
+    *out_largest = 0;
+    uint32_t cursor = start;
+
+    // Walk the partitions in address order without sorting the table
+    while (cursor < end)
+    {
+        uint32_t aligned = (cursor + align - 1) / align * align;
+        if (aligned < cursor || aligned >= end) break;
+
+        // Next partition that ends after the cursor
+        const partition_table_entry_t* next = NULL;
+        for (int i = 0; i < table->count; ++i)
+        {
+            const partition_table_entry_t* entry = &table->entries[i];
+            if (entry->offset + entry->size <= aligned) continue;
+            if (!next || entry->offset < next->offset) next = entry;
+        }
+
+        uint32_t gap_end = end;
+        if (next && next->offset < end) gap_end = next->offset;
+
+        if (gap_end > aligned)
+        {
+            if (gap_end - aligned > *out_largest) *out_largest = gap_end - aligned;
+
+            if (out_gaps && count < max_gaps)
+            {
+                out_gaps[count].offset = aligned;
+                out_gaps[count].size = gap_end - aligned;
+            }
+            ++count;
+        }
+
+        if (!next || next->offset >= end) break;
+
+        uint32_t next_end = next->offset + next->size;
+        cursor = (next_end > aligned) ? next_end : aligned;
+    }
+
+    return (count < max_gaps) ? count : max_gaps;
+}
+
+int partition_table_free_space(const partition_table_t* table, uint32_t start, uint32_t end,
+    uint32_t align, partition_table_gap_t* out_gaps, int max_gaps)
+{
+    uint32_t largest;
+    return free_space_walk(table, start, end, align, out_gaps, max_gaps, &largest);
+}
+
+// Same walk with nothing stored, so it is cheap on the main task stack
+uint32_t partition_table_largest_gap(const partition_table_t* table, uint32_t start, uint32_t end,
+    uint32_t align)
+{
+    uint32_t largest;
+    free_space_walk(table, start, end, align, NULL, 0, &largest);
+    return largest;
+}
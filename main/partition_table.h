@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Parsed copy of the ESP32 partition table with lookups and free space
+// queries. Kept free of ESP-IDF dependencies so synthetic tables can be
+// checked on a host; odroid_partition_table loads it from flash.
+
+#define PARTITION_TABLE_MAX_LEN (0xC00)
+#define PARTITION_TABLE_ENTRY_SIZE (32)
+#define PARTITION_TABLE_MAX_ENTRIES (PARTITION_TABLE_MAX_LEN / PARTITION_TABLE_ENTRY_SIZE)
+#define PARTITION_TABLE_LABEL_LENGTH (16)
+
+#define PARTITION_TABLE_MAGIC (0x50AA)
+#define PARTITION_TABLE_MAGIC_MD5 (0xEBEB)
+
+#define PARTITION_TABLE_ANY (-1)
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t subtype;
+    char label[PARTITION_TABLE_LABEL_LENGTH + 1]; // null terminated
+    uint32_t offset;
+    uint32_t size;
+    uint32_t flags;
+    int index; // entry number in the raw table
+} partition_table_entry_t;
+
+typedef struct
+{
+    uint8_t raw[PARTITION_TABLE_MAX_LEN];
+    partition_table_entry_t entries[PARTITION_TABLE_MAX_ENTRIES];
+    int count;
+    bool has_md5;
+} partition_table_t;
+
+typedef struct
+{
+    uint32_t offset;
+    uint32_t size;
+} partition_table_gap_t;
+
+typedef enum
+{
+    PARTITION_TABLE_OK = 0,
+    PARTITION_TABLE_ERR_LENGTH,
+    PARTITION_TABLE_ERR_MAGIC,
+    PARTITION_TABLE_ERR_MD5,
+    PARTITION_TABLE_ERR_OVERLAP
+} partition_table_result_t;
+
+typedef void (*partition_table_md5_fn)(const void* data, size_t length, uint8_t digest[16]);
+
+
+// Parses 'length' bytes of raw table data. When the table carries an MD5
+// record and md5 is not NULL the digest is checked.
+partition_table_result_t partition_table_parse(partition_table_t* table, const void* raw, size_t length,
+    partition_table_md5_fn md5);
+
+// type, subtype and label may be PARTITION_TABLE_ANY / NULL to match
+// anything. Returns the first match in table order.
+const partition_table_entry_t* partition_table_find(const partition_table_t* table,
+    int type, int subtype, const char* label);
+
+// Unused space in [start, end), with gap offsets rounded up to 'align'.
+// Returns the number of gaps written to out_gaps.
+int partition_table_free_space(const partition_table_t* table, uint32_t start, uint32_t end,
+    uint32_t align, partition_table_gap_t* out_gaps, int max_gaps);
+uint32_t partition_table_largest_gap(const partition_table_t* table, uint32_t start, uint32_t end,
+    uint32_t align);
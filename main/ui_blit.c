@@ -0,0 +1,145 @@
+#include "ui_blit.h"
+
+#include <string.h>
+
+
+bool ui_blit_clip(const ui_blit_surface* surface, ui_blit_rect* rect)
+{
+    short n;
+
+    if (rect->right < rect->left) { n = rect->left; rect->left = rect->right; rect->right = n; }
+    if (rect->bottom < rect->top) { n = rect->top; rect->top = rect->bottom; rect->bottom = n; }
+
+    if (rect->left < 0) rect->left = 0;
+    if (rect->top < 0) rect->top = 0;
+    if (rect->right >= surface->width) rect->right = surface->width - 1;
+    if (rect->bottom >= surface->height) rect->bottom = surface->height - 1;
+
+    return rect->left <= rect->right && rect->top <= rect->bottom;
+}
+
+void ui_blit_fill_row(uint16_t* dst, int count, uint16_t color)
+{
+    if (((uintptr_t)dst & 2) && count > 0)
+    {
+        *dst++ = color;
+        --count;
+    }
+
+    uint32_t pair = color | ((uint32_t)color << 16);
+    uint32_t* dst32 = (uint32_t*)dst;
+    for (; count >= 2; count -= 2)
+    {
+        *dst32++ = pair;
+    }
+
+    if (count) *(uint16_t*)dst32 = color;
+}
+
+void ui_blit_swap_row(uint16_t* dst, const uint16_t* src, int count)
+{
+    // Word path needs src and dst to share 32 bit alignment
+    if ((((uintptr_t)dst ^ (uintptr_t)src) & 2) == 0)
+    {
+        if (((uintptr_t)dst & 2) && count > 0)
+        {
+            uint16_t pixel = *src++;
+            *dst++ = pixel << 8 | pixel >> 8;
+            --count;
+        }
+
+        uint32_t* dst32 = (uint32_t*)dst;
+        const uint32_t* src32 = (const uint32_t*)src;
+        for (; count >= 2; count -= 2)
+        {
+            uint32_t pair = *src32++;
+            *dst32++ = ((pair & 0x00ff00ff) << 8) | ((pair >> 8) & 0x00ff00ff);
+        }
+
+        dst = (uint16_t*)dst32;
+        src = (const uint16_t*)src32;
+    }
+
+    while (count-- > 0)
+    {
+        uint16_t pixel = *src++;
+        *dst++ = pixel << 8 | pixel >> 8;
+    }
+}
+
+bool ui_blit_copy(const ui_blit_surface* dst, short x, short y, short width, short height,
+    const uint16_t* src, short src_stride, int flags, ui_blit_rect* out_drawn)
+{
+    if (width < 1 || height < 1 || src_stride < width) return false;
+
+    ui_blit_rect rect = { x, y, x + width - 1, y + height - 1 };
+    if (!ui_blit_clip(dst, &rect)) return false;
+
+    const uint16_t* from = src + (rect.top - y) * src_stride + (rect.left - x);
+    uint16_t* to = dst->pixels + rect.top * dst->stride + rect.left;
+    int count = rect.right - rect.left + 1;
+
+    for (short row = rect.top; row <= rect.bottom; ++row)
+    {
+        if (flags & UI_BLIT_SWAP)
+        {
+            ui_blit_swap_row(to, from, count);
+        }
+        else
+        {
+            memcpy(to, from, count * sizeof(uint16_t));
+        }
+
+        from += src_stride;
+        to += dst->stride;
+    }
+
+    if (out_drawn) *out_drawn = rect;
+    return true;
+}
+
+bool ui_blit_fill(const ui_blit_surface* dst, short left, short top, short right, short bottom,
+    uint16_t color, ui_blit_rect* out_drawn)
+{
+    ui_blit_rect rect = { left, top, right, bottom };
+    if (!ui_blit_clip(dst, &rect)) return false;
+
+    uint16_t* to = dst->pixels + rect.top * dst->stride + rect.left;
+    int count = rect.right - rect.left + 1;
+
+    for (short row = rect.top; row <= rect.bottom; ++row)
+    {
+        ui_blit_fill_row(to, count, color);
+        to += dst->stride;
+    }
+
+    if (out_drawn) *out_drawn = rect;
+    return true;
+}
+
+bool ui_blit_frame(const ui_blit_surface* dst, short left, short top, short right, short bottom,
+    uint16_t color, ui_blit_rect* out_drawn)
+{
+    short n;
+    if (right < left) { n = left; left = right; right = n; }
+    if (bottom < top) { n = top; top = bottom; bottom = n; }
+
+    // Edges are clipped individually so a partly visible frame only draws
+    // its visible sides.
+    bool drawn = false;
+    drawn |= ui_blit_fill(dst, left, top, right, top, color, NULL);
+    drawn |= ui_blit_fill(dst, left, bottom, right, bottom, color, NULL);
+    drawn |= ui_blit_fill(dst, left, top, left, bottom, color, NULL);
+    drawn |= ui_blit_fill(dst, right, top, right, bottom, color, NULL);
+
+    if (!drawn) return false;
+
+    if (out_drawn)
+    {
+        ui_blit_rect rect = { left, top, right, bottom };
+        ui_blit_clip(dst, &rect);
+        *out_drawn = rect;
+    }
+
+    return true;
+}
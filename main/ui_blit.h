@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// RGB565 pixel buffer. stride is in pixels and may exceed width when the
+// surface is a window into a larger buffer.
+typedef struct
+{
+    uint16_t* pixels;
+    short width;
+    short height;
+    short stride;
+} ui_blit_surface;
+
+// Inclusive rectangle, same convention as uGUI
+typedef struct
+{
+    short left;
+    short top;
+    short right;
+    short bottom;
+} ui_blit_rect;
+
+#define UI_BLIT_SWAP (1 << 0) // swap the bytes of each pixel while copying
+
+
+// All operations clip to the surface and work a row at a time. They return
+// false when nothing was drawn; otherwise out_drawn (if not NULL) receives
+// the clipped rectangle that was touched.
+bool ui_blit_clip(const ui_blit_surface* surface, ui_blit_rect* rect);
+bool ui_blit_copy(const ui_blit_surface* dst, short x, short y, short width, short height,
+    const uint16_t* src, short src_stride, int flags, ui_blit_rect* out_drawn);
+bool ui_blit_fill(const ui_blit_surface* dst, short left, short top, short right, short bottom,
+    uint16_t color, ui_blit_rect* out_drawn);
+bool ui_blit_frame(const ui_blit_surface* dst, short left, short top, short right, short bottom,
+    uint16_t color, ui_blit_rect* out_drawn);
+
+void ui_blit_fill_row(uint16_t* dst, int count, uint16_t color);
+void ui_blit_swap_row(uint16_t* dst, const uint16_t* src, int count);
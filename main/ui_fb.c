@@ -0,0 +1,151 @@
+#include "ui_fb.h"
+#include "ui_blit.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static uint16_t* fb;
+static short fb_width;
+static short fb_height;
+static ui_blit_surface surface;
+
+static short dirty_left;
+static short dirty_top;
+static short dirty_right;
+static short dirty_bottom;
+
+// FILL_AREA streaming cursor
+static short area_left;
+static short area_right;
+static short area_bottom;
+static short cursor_x;
+static short cursor_y;
+
+
+void ui_fb_mark_dirty(short left, short top, short right, short bottom)
+{
+    if (left < dirty_left) dirty_left = left;
+    if (top < dirty_top) dirty_top = top;
+    if (right > dirty_right) dirty_right = right;
+    if (bottom > dirty_bottom) dirty_bottom = bottom;
+}
+
+bool ui_fb_dirty_get(short* left, short* top, short* width, short* height)
+{
+    if (dirty_right < dirty_left || dirty_bottom < dirty_top) return false;
+
+    *left = dirty_left;
+    *top = dirty_top;
+    *width = dirty_right - dirty_left + 1;
+    *height = dirty_bottom - dirty_top + 1;
+
+    return true;
+}
+
+void ui_fb_dirty_clear()
+{
+    dirty_left = fb_width;
+    dirty_top = fb_height;
+    dirty_right = -1;
+    dirty_bottom = -1;
+}
+
+void ui_fb_pset(UG_S16 x, UG_S16 y, UG_COLOR color)
+{
+    if (x < 0 || y < 0 || x >= fb_width || y >= fb_height) return;
+
+    fb[y * fb_width + x] = color;
+    ui_fb_mark_dirty(x, y, x, y);
+}
+
+void ui_fb_draw_image(short x, short y, short width, short height, const uint16_t* data)
+{
+    ui_blit_rect drawn;
+    if (ui_blit_copy(&surface, x, y, width, height, data, width, 0, &drawn))
+    {
+        ui_fb_mark_dirty(drawn.left, drawn.top, drawn.right, drawn.bottom);
+    }
+}
+
+void ui_fb_draw_frame(short left, short top, short right, short bottom, uint16_t color)
+{
+    ui_blit_rect drawn;
+    if (ui_blit_frame(&surface, left, top, right, bottom, color, &drawn))
+    {
+        ui_fb_mark_dirty(drawn.left, drawn.top, drawn.right, drawn.bottom);
+    }
+}
+
+static UG_RESULT driver_fill_frame(UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c)
+{
+    ui_blit_rect drawn;
+    if (ui_blit_fill(&surface, x1, y1, x2, y2, c, &drawn))
+    {
+        ui_fb_mark_dirty(drawn.left, drawn.top, drawn.right, drawn.bottom);
+    }
+
+    return UG_RESULT_OK;
+}
+
+static UG_RESULT driver_draw_line(UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c)
+{
+    // Only axis aligned lines are accelerated; uGUI rasterizes the rest
+    if (x1 != x2 && y1 != y2) return UG_RESULT_FAIL;
+
+    return driver_fill_frame(x1, y1, x2, y2, c);
+}
+
+static void area_push_pixel(UG_COLOR c)
+{
+    if (cursor_x >= 0 && cursor_x < fb_width && cursor_y >= 0 && cursor_y < fb_height)
+    {
+        fb[cursor_y * fb_width + cursor_x] = c;
+    }
+
+    if (++cursor_x > area_right)
+    {
+        cursor_x = area_left;
+        if (cursor_y < area_bottom) ++cursor_y;
+    }
+}
+
+static void* driver_fill_area(UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2)
+{
+    area_left = x1;
+    area_right = x2;
+    area_bottom = y2;
+    cursor_x = x1;
+    cursor_y = y1;
+
+    ui_blit_rect rect = { x1, y1, x2, y2 };
+    if (ui_blit_clip(&surface, &rect))
+    {
+        ui_fb_mark_dirty(rect.left, rect.top, rect.right, rect.bottom);
+    }
+
+    return area_push_pixel;
+}
+
+void ui_fb_init(uint16_t* buffer, short width, short height)
+{
+    if (!buffer || width < 1 || height < 1) abort();
+
+    fb = buffer;
+    fb_width = width;
+    fb_height = height;
+
+    surface.pixels = buffer;
+    surface.width = width;
+    surface.height = height;
+    surface.stride = width;
+
+    // Everything is dirty until the first flush
+    ui_fb_dirty_clear();
+    ui_fb_mark_dirty(0, 0, width - 1, height - 1);
+
+    UG_DriverRegister(DRIVER_FILL_FRAME, (void*)driver_fill_frame);
+    UG_DriverRegister(DRIVER_FILL_AREA, (void*)driver_fill_area);
+    UG_DriverRegister(DRIVER_DRAW_LINE, (void*)driver_draw_line);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../components/ugui/ugui.h"
+
+
+// uGUI backend for the RGB565 framebuffer. Registers accelerated
+// DRIVER_FILL_FRAME, DRIVER_FILL_AREA and DRIVER_DRAW_LINE handlers and
+// tracks the bounding box of everything drawn since the last flush.
+void ui_fb_init(uint16_t* buffer, short width, short height);
+void ui_fb_pset(UG_S16 x, UG_S16 y, UG_COLOR color);
+void ui_fb_draw_image(short x, short y, short width, short height, const uint16_t* data);
+void ui_fb_draw_frame(short left, short top, short right, short bottom, uint16_t color);
+
+void ui_fb_mark_dirty(short left, short top, short right, short bottom);
+bool ui_fb_dirty_get(short* left, short* top, short* width, short* height);
+void ui_fb_dirty_clear();
@@ -0,0 +1,239 @@
+#include "ui_glyph_cache.h"
+#include "ui_fb.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define SLOT_COUNT (128) // power of two
+
+
+typedef struct
+{
+    const unsigned char* font_data;
+    uint16_t* pixels;
+    uint32_t last_used;
+    UG_COLOR fc;
+    UG_COLOR bc;
+    uint8_t chr;
+    uint8_t width;
+    uint8_t height;
+    uint8_t used;
+} glyph_entry;
+
+static glyph_entry slots[SLOT_COUNT];
+static uint32_t use_clock;
+static ui_glyph_cache_stats stats;
+
+
+static uint32_t glyph_hash(const unsigned char* font_data, uint8_t chr, UG_COLOR fc, UG_COLOR bc)
+{
+    uint32_t h = (uint32_t)(uintptr_t)font_data;
+    h = (h ^ chr) * 0x01000193;
+    h = (h ^ fc) * 0x01000193;
+    h = (h ^ bc) * 0x01000193;
+    return h ^ (h >> 16);
+}
+
+static void glyph_free(glyph_entry* entry)
+{
+    stats.bytes_used -= entry->width * entry->height * sizeof(uint16_t);
+
+    free(entry->pixels);
+    memset(entry, 0, sizeof(*entry));
+}
+
+// Same decoding as _UG_PutChar, done once per cached tile
+static void glyph_rasterize(uint16_t* out, uint8_t chr, UG_COLOR fc, UG_COLOR bc, const UG_FONT* font, int width)
+{
+    if (font->font_type == FONT_TYPE_1BPP)
+    {
+        int bn = (font->char_width + 7) >> 3;
+        uint32_t index = (chr - font->start_char) * font->char_height * bn;
+
+        for (int j = 0; j < font->char_height; ++j)
+        {
+            int c = width;
+            for (int i = 0; i < bn; ++i)
+            {
+                uint8_t b = font->p[index++];
+                for (int k = 0; (k < 8) && c; ++k)
+                {
+                    *out++ = (b & 0x01) ? fc : bc;
+                    b >>= 1;
+                    c--;
+                }
+            }
+        }
+    }
+    else if (font->font_type == FONT_TYPE_SPAN)
+    {
+        const UG_SPAN_DATA* spans = (const UG_SPAN_DATA*)font->p;
+        const uint8_t* run = spans->runs + spans->offsets[chr - font->start_char];
+
+        for (int j = 0; j < font->char_height; ++j)
+        {
+            for (int i = 0; i < width; ++i)
+            {
+                out[i] = bc;
+            }
+
+            int count = *run++;
+            while (count--)
+            {
+                for (int i = run[0]; i < run[0] + run[1]; ++i)
+                {
+                    out[i] = fc;
+                }
+                run += 2;
+            }
+
+            out += width;
+        }
+    }
+    else
+    {
+        uint32_t index = (chr - font->start_char) * font->char_height * font->char_width;
+
+        for (int j = 0; j < font->char_height; ++j)
+        {
+            for (int i = 0; i < width; ++i)
+            {
+                uint32_t b = font->p[index++];
+                *out++ = ((((fc & 0x0000FF) * b + (bc & 0x0000FF) * (256 - b)) >> 8) & 0x0000FF) |
+                         ((((fc & 0x00FF00) * b + (bc & 0x00FF00) * (256 - b)) >> 8) & 0x00FF00) |
+                         ((((fc & 0xFF0000) * b + (bc & 0xFF0000) * (256 - b)) >> 8) & 0xFF0000);
+            }
+            index += font->char_width - width;
+        }
+    }
+}
+
+static void evict_lru()
+{
+    glyph_entry* victim = NULL;
+    for (int i = 0; i < SLOT_COUNT; ++i)
+    {
+        if (slots[i].used && (!victim || slots[i].last_used < victim->last_used))
+        {
+            victim = &slots[i];
+        }
+    }
+
+    if (victim)
+    {
+        glyph_free(victim);
+        stats.evictions++;
+    }
+}
+
+static glyph_entry* glyph_insert(uint8_t chr, UG_COLOR fc, UG_COLOR bc, const UG_FONT* font, int width)
+{
+    size_t length = width * font->char_height * sizeof(uint16_t);
+    if (length > stats.bytes_budget) return NULL;
+
+    while (stats.bytes_used + length > stats.bytes_budget)
+    {
+        evict_lru();
+    }
+
+    // Linear probe for a free slot, evicting when the table is full
+    uint32_t h = glyph_hash(font->p, chr, fc, bc);
+    glyph_entry* entry = NULL;
+    while (!entry)
+    {
+        for (int i = 0; i < SLOT_COUNT; ++i)
+        {
+            glyph_entry* candidate = &slots[(h + i) & (SLOT_COUNT - 1)];
+            if (!candidate->used)
+            {
+                entry = candidate;
+                break;
+            }
+        }
+
+        if (!entry) evict_lru();
+    }
+
+    entry->pixels = (uint16_t*)malloc(length);
+    if (!entry->pixels) return NULL;
+
+    glyph_rasterize(entry->pixels, chr, fc, bc, font, width);
+
+    entry->font_data = font->p;
+    entry->chr = chr;
+    entry->fc = fc;
+    entry->bc = bc;
+    entry->width = width;
+    entry->height = font->char_height;
+    entry->used = 1;
+
+    stats.bytes_used += length;
+
+    return entry;
+}
+
+static glyph_entry* glyph_find(uint8_t chr, UG_COLOR fc, UG_COLOR bc, const UG_FONT* font)
+{
+    // Eviction leaves holes in probe sequences, so probe the whole table
+    uint32_t h = glyph_hash(font->p, chr, fc, bc);
+    for (int i = 0; i < SLOT_COUNT; ++i)
+    {
+        glyph_entry* entry = &slots[(h + i) & (SLOT_COUNT - 1)];
+        if (entry->used && entry->chr == chr && entry->font_data == font->p &&
+            entry->fc == fc && entry->bc == bc && entry->height == font->char_height)
+        {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static UG_RESULT driver_put_char(UG_U8 chr, UG_S16 x, UG_S16 y, UG_COLOR fc, UG_COLOR bc, const UG_FONT* font)
+{
+    int width = font->widths ? font->widths[chr - font->start_char] : font->char_width;
+    if (width < 1 || width > 255 || font->char_height > 255) return UG_RESULT_FAIL;
+
+    glyph_entry* entry = glyph_find(chr, fc, bc, font);
+    if (entry)
+    {
+        stats.hits++;
+    }
+    else
+    {
+        stats.misses++;
+
+        entry = glyph_insert(chr, fc, bc, font, width);
+        if (!entry) return UG_RESULT_FAIL;
+    }
+
+    entry->last_used = ++use_clock;
+
+    ui_fb_draw_image(x, y, entry->width, entry->height, entry->pixels);
+    return UG_RESULT_OK;
+}
+
+void ui_glyph_cache_clear()
+{
+    for (int i = 0; i < SLOT_COUNT; ++i)
+    {
+        if (slots[i].used) glyph_free(&slots[i]);
+    }
+}
+
+void ui_glyph_cache_stats_get(ui_glyph_cache_stats* out_stats)
+{
+    *out_stats = stats;
+}
+
+void ui_glyph_cache_init(size_t budget_bytes)
+{
+    ui_glyph_cache_clear();
+
+    memset(&stats, 0, sizeof(stats));
+    stats.bytes_budget = budget_bytes;
+
+    UG_DriverRegister(DRIVER_PUT_CHAR, (void*)driver_put_char);
+}
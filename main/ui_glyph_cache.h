@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+typedef struct
+{
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    size_t bytes_used;
+    size_t bytes_budget;
+} ui_glyph_cache_stats;
+
+
+// Expands each (font, glyph, foreground, background) combination once into
+// an RGB565 tile and registers a uGUI DRIVER_PUT_CHAR handler that blits
+// cached tiles into the framebuffer. Tile memory is bounded by
+// budget_bytes; the least recently used tiles are evicted first.
+void ui_glyph_cache_init(size_t budget_bytes);
+void ui_glyph_cache_clear();
+void ui_glyph_cache_stats_get(ui_glyph_cache_stats* out_stats);
@@ -0,0 +1,115 @@
+#include "ui_fb.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+// A browser redraw as ui_draw_page does it (title, header, footer and a
+// page of file names, without the tiles) through plain uGUI with only a
+// pset callback, and through uGUI with the ui_fb drivers registered.
+// Host numbers only show relative cost. Run with: make -C test/host bench
+
+#define WIDTH (320)
+#define HEIGHT (240)
+#define ITEM_COUNT (4)
+#define ITERATIONS (500)
+
+static uint16_t fb[WIDTH * HEIGHT];
+static uint16_t reference[WIDTH * HEIGHT];
+static UG_GUI gui;
+
+static const char* const names[ITEM_COUNT] = {
+    "Super Mario Bros", "The Legend of Zelda", "Tetris DX", "Metroid II - Return of Samus" };
+
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// The callback main.c used before ui_fb
+static void pset(UG_S16 x, UG_S16 y, UG_COLOR color)
+{
+    fb[y * WIDTH + x] = color;
+}
+
+static void draw_page(int currentItem)
+{
+    char TITLE[] = "ODROID-GO";
+    char VERSION[] = "20261019-bench";
+
+    // ui_draw_title
+    UG_FillFrame(0, 0, 319, 239, C_WHITE);
+
+    UG_FillFrame(0, 0, 319, 15, C_MIDNIGHT_BLUE);
+    UG_FontSelect(&FONT_8X8);
+    UG_SetForecolor(C_WHITE);
+    UG_SetBackcolor(C_MIDNIGHT_BLUE);
+    UG_PutString((320 / 2) - (strlen(TITLE) * 9 / 2), 4, TITLE);
+
+    UG_FillFrame(0, 239 - 16, 319, 239, C_MIDNIGHT_BLUE);
+    UG_SetForecolor(C_DARK_GRAY);
+    UG_PutString((320 / 2) - (strlen(VERSION) * 9 / 2), 240 - 4 - 8, VERSION);
+
+    // The page
+    const int itemHeight = (240 - (16 * 2)) / ITEM_COUNT;
+    const short textLeft = 320 - 213;
+
+    for (int line = 0; line < ITEM_COUNT; ++line)
+    {
+        short top = 16 + (line * itemHeight) - 1;
+        UG_COLOR back = (line == currentItem) ? C_YELLOW : C_WHITE;
+
+        UG_SetForecolor(C_BLACK);
+        UG_SetBackcolor(back);
+        UG_FillFrame(0, top + 2, 319, top + itemHeight - 1 - 1, back);
+
+        UG_FontSelect(&FONT_8X12);
+        UG_PutString(textLeft, top + 2 + 2 + 16, (char*)names[line]);
+    }
+}
+
+static double run()
+{
+    double start = now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        draw_page(i % ITEM_COUNT);
+        ui_fb_dirty_clear();
+    }
+
+    return (now() - start) / ITERATIONS;
+}
+
+
+int main()
+{
+    printf("ui_draw_page %dx%d, %d redraws:\n", WIDTH, HEIGHT, ITERATIONS);
+
+    // ui_fb_init also sets up the dirty tracking run() clears
+    UG_Init(&gui, pset, WIDTH, HEIGHT);
+    ui_fb_init(fb, WIDTH, HEIGHT);
+    UG_DriverDisable(DRIVER_FILL_FRAME);
+    UG_DriverDisable(DRIVER_FILL_AREA);
+    UG_DriverDisable(DRIVER_DRAW_LINE);
+    double plain = run();
+    memcpy(reference, fb, sizeof(fb));
+    printf("  %-22s %8.1f us/page\n", "uGUI, pset only", plain * 1e6);
+
+    memset(fb, 0, sizeof(fb));
+    UG_Init(&gui, ui_fb_pset, WIDTH, HEIGHT);
+    ui_fb_init(fb, WIDTH, HEIGHT);
+    double drivers = run();
+    printf("  %-22s %8.1f us/page (%.1fx)\n", "uGUI + ui_fb drivers", drivers * 1e6, plain / drivers);
+
+    if (memcmp(reference, fb, sizeof(fb)) != 0)
+    {
+        printf("  the two pages differ\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdio.h>
+
+// Minimal assertion helpers for the host checks. A failed CHECK is reported
+// and counted; CHECK_DONE prints a summary and yields the exit status.
+
+static int check_count;
+static int check_failures;
+
+#define CHECK(cond) \
+    do \
+    { \
+        ++check_count; \
+        if (!(cond)) \
+        { \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++check_failures; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do \
+    { \
+        long long check_a = (long long)(a); \
+        long long check_b = (long long)(b); \
+        ++check_count; \
+        if (check_a != check_b) \
+        { \
+            printf("%s:%d: CHECK failed: %s == %s (%lld != %lld)\n", \
+                __FILE__, __LINE__, #a, #b, check_a, check_b); \
+            ++check_failures; \
+        } \
+    } while (0)
+
+#define CHECK_DONE() \
+    (printf("%s: %d checks, %d failed\n", __FILE__, check_count, check_failures), \
+     check_failures ? 1 : 0)
@@ -0,0 +1,132 @@
+#pragma once
+
+// D-pad ADC traces for test_input_debounce, one {x, y} sample per 10 ms
+// input task period. No capture from a unit ships with the tree, so these
+// are synthesized from the ladder's readings (rest near 0 with noise,
+// RIGHT/DOWN mid-scale, LEFT/UP full scale) with the artefacts seen on
+// real pads:
+// - a sample in the mid band while a full-scale press rises or falls
+// - a single contact dropout in the middle of a mid-scale hold
+// - on the worn unit, the rest reading creeping past the stock 1024
+//   threshold to about 1100, with RIGHT near 1600 and LEFT near 3900
+// Regenerate only together with the expectations in the test.
+
+typedef struct
+{
+    int x;
+    int y;
+} input_trace_sample_t;
+
+static const input_trace_sample_t trace_rest[] = {
+    { 55, 36 }, { 34, 2 }, { 17, 27 }, { 5, 10 }, { 19, 26 }, { 5, 26 }, { 13, 1 }, { 2, 6 },
+    { 3, 23 }, { 21, 20 }, { 12, 20 }, { 16, 19 }, { 4, 25 }, { 9, 15 }, { 11, 35 }, { 14, 9 },
+    { 22, 34 }, { 12, 17 }, { 3, 14 }, { 4, 36 }, { 35, 12 }, { 12, 9 }, { 24, 20 }, { 39, 22 },
+    { 49, 8 }, { 24, 23 }, { 5, 14 }, { 5, 54 }, { 0, 32 }, { 0, 8 }, { 10, 4 }, { 49, 6 },
+    { 15, 52 }, { 29, 22 }, { 2, 14 }, { 21, 56 }, { 0, 28 }, { 12, 64 }, { 9, 7 }, { 28, 22 },
+    { 18, 17 }, { 4, 29 }, { 2, 13 }, { 8, 6 }, { 47, 30 }, { 66, 22 }, { 16, 61 }, { 10, 28 },
+    { 33, 39 }, { 21, 5 }, { 23, 20 }, { 8, 11 }, { 2, 4 }, { 19, 19 }, { 12, 4 }, { 28, 55 },
+    { 24, 9 }, { 39, 29 }, { 50, 16 }, { 33, 7 }, { 7, 7 }, { 52, 15 }, { 19, 38 }, { 8, 60 },
+    { 27, 35 }, { 9, 13 }, { 29, 5 }, { 20, 4 }, { 13, 16 }, { 37, 10 }, { 9, 19 }, { 20, 6 },
+    { 3, 4 }, { 34, 51 }, { 1, 19 }, { 41, 18 }, { 14, 37 }, { 29, 3 }, { 39, 4 }, { 51, 23 },
+    { 4, 5 }, { 14, 3 }, { 29, 19 }, { 10, 15 }, { 19, 14 }, { 9, 21 }, { 30, 3 }, { 12, 37 },
+    { 2, 20 }, { 23, 52 }, { 21, 18 }, { 10, 47 }, { 34, 13 }, { 31, 24 }, { 62, 8 }, { 1, 5 },
+    { 9, 9 }, { 48, 21 }, { 12, 15 }, { 45, 2 }, { 25, 4 }, { 31, 31 }, { 16, 17 }, { 1, 38 },
+    { 29, 9 }, { 7, 31 }, { 28, 37 }, { 3, 20 }, { 10, 8 }, { 12, 51 }, { 14, 3 }, { 19, 10 },
+    { 0, 31 }, { 5, 7 }, { 11, 19 }, { 6, 47 }, { 54, 45 }, { 5, 14 }, { 26, 11 }, { 5, 39 },
+    { 22, 4 }, { 37, 21 }, { 5, 30 }, { 7, 26 }, { 26, 20 }, { 17, 18 }, { 18, 11 }, { 14, 95 },
+    { 61, 47 }, { 12, 5 }, { 6, 41 }, { 47, 49 }, { 22, 2 }, { 9, 13 }, { 15, 9 }, { 4, 42 },
+    { 31, 28 }, { 10, 19 }, { 31, 2 }, { 45, 23 }, { 8, 33 }, { 9, 7 }, { 30, 8 }, { 5, 2 },
+    { 7, 44 }, { 21, 20 }, { 20, 13 }, { 23, 51 }, { 5, 15 }, { 18, 18 },
+};
+
+static const input_trace_sample_t trace_left[] = {
+    { 12, 9 }, { 24, 34 }, { 14, 12 }, { 31, 2 }, { 8, 2 }, { 35, 1 }, { 25, 32 }, { 22, 12 },
+    { 2, 37 }, { 9, 11 }, { 9, 15 }, { 3, 46 }, { 21, 3 }, { 57, 19 }, { 41, 39 }, { 4, 35 },
+    { 67, 21 }, { 38, 0 }, { 16, 8 }, { 20, 38 }, { 1700, 7 }, { 3300, 33 }, { 4089, 18 },
+    { 4084, 15 }, { 4093, 13 }, { 4086, 9 }, { 4082, 37 }, { 4095, 24 }, { 4087, 14 }, { 4090, 13 },
+    { 4093, 15 }, { 4094, 8 }, { 4094, 30 }, { 4066, 44 }, { 4085, 18 }, { 4080, 18 }, { 4078, 36 },
+    { 4090, 23 }, { 4085, 17 }, { 4092, 28 }, { 4070, 20 }, { 4081, 17 }, { 4072, 37 },
+    { 4086, 28 }, { 4090, 7 }, { 4090, 25 }, { 4085, 17 }, { 4079, 3 }, { 4092, 55 }, { 4090, 32 },
+    { 4071, 16 }, { 4083, 57 }, { 2200, 22 }, { 700, 2 }, { 14, 2 }, { 28, 20 }, { 6, 21 },
+    { 13, 44 }, { 13, 21 }, { 20, 15 }, { 0, 37 }, { 7, 19 }, { 54, 15 }, { 10, 7 }, { 16, 18 },
+    { 10, 22 }, { 25, 31 }, { 2, 17 }, { 28, 3 }, { 19, 5 }, { 20, 18 }, { 2, 35 }, { 0, 22 },
+    { 16, 19 },
+};
+
+static const input_trace_sample_t trace_right[] = {
+    { 5, 10 }, { 17, 8 }, { 1, 56 }, { 13, 16 }, { 36, 4 }, { 27, 28 }, { 2, 19 }, { 26, 1 },
+    { 53, 22 }, { 10, 37 }, { 0, 23 }, { 6, 33 }, { 17, 45 }, { 1, 53 }, { 10, 7 }, { 16, 10 },
+    { 31, 10 }, { 34, 7 }, { 33, 2 }, { 2, 16 }, { 1200, 18 }, { 1917, 35 }, { 1939, 26 },
+    { 1923, 1 }, { 1853, 43 }, { 1940, 6 }, { 1929, 8 }, { 1845, 22 }, { 1898, 38 }, { 1934, 20 },
+    { 1880, 38 }, { 1924, 3 }, { 1909, 16 }, { 1948, 8 }, { 1895, 13 }, { 310, 27 }, { 1861, 21 },
+    { 1892, 10 }, { 1842, 44 }, { 1901, 3 }, { 1950, 3 }, { 1958, 10 }, { 1964, 7 }, { 1908, 43 },
+    { 1821, 23 }, { 1915, 10 }, { 1922, 5 }, { 1899, 3 }, { 1937, 44 }, { 1906, 24 }, { 1870, 6 },
+    { 900, 11 }, { 4, 18 }, { 18, 34 }, { 9, 12 }, { 4, 2 }, { 24, 20 }, { 10, 2 }, { 11, 3 },
+    { 28, 24 }, { 16, 63 }, { 28, 21 }, { 7, 8 }, { 56, 14 }, { 2, 26 }, { 20, 4 }, { 28, 31 },
+    { 10, 1 }, { 56, 21 }, { 38, 25 }, { 53, 21 }, { 9, 9 },
+};
+
+static const input_trace_sample_t trace_up[] = {
+    { 16, 3 }, { 9, 46 }, { 15, 45 }, { 8, 6 }, { 0, 3 }, { 8, 22 }, { 29, 6 }, { 31, 29 },
+    { 1, 23 }, { 7, 14 }, { 19, 56 }, { 4, 15 }, { 14, 5 }, { 20, 29 }, { 40, 55 }, { 10, 34 },
+    { 6, 19 }, { 38, 34 }, { 17, 7 }, { 19, 2 }, { 22, 1700 }, { 15, 3300 }, { 10, 4087 },
+    { 10, 4092 }, { 33, 4091 }, { 28, 4084 }, { 11, 4093 }, { 8, 4071 }, { 20, 4085 }, { 26, 4083 },
+    { 1, 4076 }, { 63, 4079 }, { 53, 4093 }, { 13, 4090 }, { 26, 4083 }, { 31, 4091 }, { 36, 4062 },
+    { 35, 4075 }, { 29, 4072 }, { 4, 4085 }, { 43, 4093 }, { 32, 4093 }, { 24, 4084 }, { 7, 4074 },
+    { 36, 4086 }, { 12, 4082 }, { 29, 4074 }, { 2, 4089 }, { 15, 4076 }, { 14, 4070 }, { 18, 4090 },
+    { 17, 4093 }, { 5, 2200 }, { 17, 700 }, { 15, 6 }, { 4, 30 }, { 30, 8 }, { 29, 32 }, { 38, 1 },
+    { 26, 14 }, { 3, 1 }, { 17, 7 }, { 37, 9 }, { 16, 8 }, { 3, 11 }, { 14, 38 }, { 19, 86 },
+    { 50, 7 }, { 6, 3 }, { 8, 24 }, { 11, 22 }, { 3, 24 }, { 28, 12 }, { 7, 33 },
+};
+
+static const input_trace_sample_t trace_down[] = {
+    { 9, 11 }, { 33, 26 }, { 5, 41 }, { 20, 16 }, { 7, 33 }, { 27, 11 }, { 41, 13 }, { 14, 59 },
+    { 24, 22 }, { 22, 3 }, { 38, 12 }, { 6, 11 }, { 4, 32 }, { 27, 1 }, { 4, 22 }, { 33, 48 },
+    { 19, 13 }, { 47, 1 }, { 41, 2 }, { 25, 9 }, { 35, 1200 }, { 6, 1848 }, { 21, 1895 },
+    { 27, 1931 }, { 34, 1951 }, { 20, 1831 }, { 30, 1914 }, { 10, 1905 }, { 13, 1955 },
+    { 10, 1886 }, { 4, 1898 }, { 31, 1905 }, { 30, 1922 }, { 52, 1861 }, { 5, 1883 }, { 51, 310 },
+    { 28, 1853 }, { 31, 1922 }, { 26, 1823 }, { 12, 1936 }, { 2, 1914 }, { 15, 1906 }, { 1, 1900 },
+    { 47, 1890 }, { 18, 1863 }, { 8, 1962 }, { 29, 1906 }, { 4, 1915 }, { 6, 1880 }, { 1, 1882 },
+    { 34, 1961 }, { 19, 900 }, { 2, 16 }, { 10, 36 }, { 21, 6 }, { 21, 9 }, { 35, 26 }, { 2, 1 },
+    { 29, 3 }, { 7, 10 }, { 17, 2 }, { 17, 16 }, { 15, 29 }, { 7, 20 }, { 1, 39 }, { 4, 4 },
+    { 11, 48 }, { 28, 42 }, { 29, 50 }, { 47, 26 }, { 18, 22 }, { 14, 2 },
+};
+
+static const input_trace_sample_t trace_worn[] = {
+    { 296, 16 }, { 322, 24 }, { 290, 39 }, { 303, 19 }, { 348, 14 }, { 388, 38 }, { 324, 54 },
+    { 382, 13 }, { 340, 28 }, { 389, 13 }, { 402, 27 }, { 449, 10 }, { 419, 31 }, { 465, 0 },
+    { 538, 7 }, { 467, 9 }, { 483, 15 }, { 490, 14 }, { 422, 6 }, { 452, 9 }, { 468, 11 },
+    { 520, 24 }, { 476, 29 }, { 464, 1 }, { 562, 8 }, { 537, 7 }, { 613, 3 }, { 521, 14 },
+    { 606, 33 }, { 559, 23 }, { 516, 42 }, { 604, 31 }, { 628, 14 }, { 642, 18 }, { 653, 23 },
+    { 695, 30 }, { 683, 17 }, { 704, 6 }, { 703, 0 }, { 657, 35 }, { 684, 8 }, { 634, 9 },
+    { 742, 6 }, { 763, 35 }, { 691, 35 }, { 666, 9 }, { 757, 9 }, { 777, 1 }, { 778, 10 },
+    { 774, 16 }, { 723, 44 }, { 842, 7 }, { 853, 12 }, { 838, 3 }, { 790, 49 }, { 895, 15 },
+    { 799, 12 }, { 897, 35 }, { 844, 26 }, { 886, 0 }, { 911, 51 }, { 956, 71 }, { 878, 19 },
+    { 954, 6 }, { 910, 3 }, { 1003, 29 }, { 968, 24 }, { 976, 4 }, { 982, 59 }, { 932, 1 },
+    { 995, 12 }, { 997, 20 }, { 1067, 20 }, { 1118, 11 }, { 1053, 32 }, { 1045, 13 }, { 1027, 22 },
+    { 1104, 18 }, { 1073, 49 }, { 1073, 24 }, { 1156, 32 }, { 1106, 20 }, { 1091, 7 }, { 1095, 22 },
+    { 1110, 62 }, { 1100, 13 }, { 1065, 21 }, { 1071, 23 }, { 1137, 39 }, { 1110, 4 }, { 1090, 12 },
+    { 1083, 23 }, { 1126, 3 }, { 1069, 28 }, { 1118, 54 }, { 1125, 26 }, { 1116, 30 }, { 1105, 7 },
+    { 1120, 5 }, { 1079, 0 }, { 1100, 1 }, { 1156, 32 }, { 1133, 32 }, { 1070, 18 }, { 1156, 42 },
+    { 1131, 16 }, { 1079, 6 }, { 1029, 8 }, { 1066, 43 }, { 1139, 45 }, { 1122, 12 }, { 1132, 39 },
+    { 1119, 23 }, { 1073, 26 }, { 1109, 2 }, { 1062, 6 }, { 1111, 12 }, { 1052, 6 }, { 1136, 3 },
+    { 1104, 22 }, { 1350, 6 }, { 1597, 4 }, { 1579, 11 }, { 1618, 0 }, { 1686, 12 }, { 1612, 3 },
+    { 1535, 40 }, { 1618, 27 }, { 1487, 29 }, { 1579, 21 }, { 1578, 1 }, { 1645, 14 }, { 1626, 36 },
+    { 1577, 49 }, { 1641, 25 }, { 1626, 24 }, { 1613, 4 }, { 1597, 60 }, { 1550, 38 }, { 1634, 13 },
+    { 1606, 32 }, { 1615, 9 }, { 1603, 7 }, { 1578, 6 }, { 1644, 15 }, { 1573, 53 }, { 1640, 15 },
+    { 1539, 12 }, { 1658, 16 }, { 1591, 37 }, { 1617, 1 }, { 1300, 12 }, { 1057, 18 }, { 1089, 22 },
+    { 1060, 3 }, { 1056, 24 }, { 1151, 3 }, { 1138, 10 }, { 1100, 32 }, { 1083, 6 }, { 1132, 4 },
+    { 1054, 16 }, { 1094, 24 }, { 1071, 89 }, { 1115, 5 }, { 1073, 2 }, { 1015, 42 }, { 1087, 22 },
+    { 1067, 23 }, { 1097, 17 }, { 1141, 30 }, { 1082, 16 }, { 1046, 2 }, { 1120, 16 }, { 1142, 29 },
+    { 1076, 1 }, { 1081, 35 }, { 1096, 2 }, { 1119, 5 }, { 1138, 15 }, { 1026, 45 }, { 1123, 10 },
+    { 1900, 34 }, { 3200, 21 }, { 3893, 22 }, { 3895, 3 }, { 3898, 13 }, { 3864, 23 }, { 3885, 29 },
+    { 3899, 17 }, { 3875, 40 }, { 3896, 48 }, { 3892, 8 }, { 3895, 16 }, { 3899, 23 }, { 3871, 37 },
+    { 3899, 5 }, { 3897, 2 }, { 3893, 8 }, { 3885, 86 }, { 3874, 15 }, { 3889, 9 }, { 3873, 19 },
+    { 3877, 11 }, { 3897, 27 }, { 3896, 11 }, { 3851, 1 }, { 3882, 21 }, { 3870, 31 }, { 3899, 24 },
+    { 3898, 20 }, { 3844, 6 }, { 3898, 51 }, { 3877, 34 }, { 2300, 17 }, { 1300, 43 }, { 1069, 11 },
+    { 1043, 31 }, { 1110, 5 }, { 1063, 7 }, { 1165, 35 }, { 1112, 28 }, { 1054, 43 }, { 1070, 9 },
+    { 1067, 10 }, { 1080, 2 }, { 1118, 15 }, { 1175, 6 }, { 1051, 9 }, { 1155, 20 }, { 1095, 43 },
+    { 1109, 0 }, { 1104, 8 }, { 1114, 9 }, { 1121, 14 }, { 1073, 11 }, { 1116, 5 }, { 1083, 23 },
+    { 1094, 13 }, { 1107, 32 }, { 1169, 5 }, { 1092, 21 }, { 1112, 16 }, { 1110, 25 }, { 1140, 13 },
+    { 1093, 5 },
+};
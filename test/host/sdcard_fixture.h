@@ -0,0 +1,107 @@
+#pragma once
+
+#include "odroid_sdcard.h"
+#include "shim/shim.h"
+
+#include <dirent.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// A mounted card backed by the shim: every file exists both in the fake
+// FAT volume (raw sector reads) and in a temporary host directory that
+// stands in for the VFS mount (fragmented files).
+
+static char fixture_base[16];
+
+static void fixture_remove_all()
+{
+    DIR* dir = opendir(fixture_base);
+    if (!dir) return;
+
+    struct dirent* entry;
+    char path[300];
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] == '.') continue;
+
+        snprintf(path, sizeof(path), "%s/%s", fixture_base, entry->d_name);
+        unlink(path);
+    }
+
+    closedir(dir);
+}
+
+static void fixture_open()
+{
+    strcpy(fixture_base, "/tmp/sdXXXXXX");
+    if (!mkdtemp(fixture_base)) abort();
+
+    shim_reset();
+    if (odroid_sdcard_open(fixture_base) != ESP_OK) abort();
+}
+
+static void fixture_close()
+{
+    odroid_sdcard_close();
+    fixture_remove_all();
+    rmdir(fixture_base);
+}
+
+static uint8_t fixture_byte(size_t index, int seed)
+{
+    return (uint8_t)(index * 7 + (index >> 9) + seed);
+}
+
+static uint8_t* fixture_pattern(size_t size, int seed)
+{
+    uint8_t* data = malloc(size ? size : 1);
+    if (!data) abort();
+
+    for (size_t i = 0; i < size; ++i) data[i] = fixture_byte(i, seed);
+    return data;
+}
+
+// Creates 'name' holding the pattern for 'seed' and writes its full path
+// to 'out_path' (at least 64 bytes)
+static void fixture_file(const char* name, size_t size, int seed, bool fragmented, char* out_path)
+{
+    uint8_t* data = fixture_pattern(size, seed);
+
+    snprintf(out_path, 64, "%s/%s", fixture_base, name);
+    FILE* f = fopen(out_path, "wb");
+    if (!f || fwrite(data, 1, size, f) != size) abort();
+    fclose(f);
+
+    char fatName[64];
+    snprintf(fatName, sizeof(fatName), "/%s", name);
+    shim_fat_add(fatName, data, size, fragmented);
+
+    free(data);
+}
+
+static int fixture_fd_count()
+{
+    DIR* dir = opendir("/proc/self/fd");
+    if (!dir) return -1;
+
+    int count = 0;
+    while (readdir(dir)) ++count;
+
+    closedir(dir);
+    return count;
+}
+
+static size_t fixture_heap_used()
+{
+    return mallinfo2().uordblks;
+}
+
+// Reader tasks signal completion just before deleting themselves
+static bool fixture_tasks_finished()
+{
+    for (int i = 0; i < 1000 && shim_tasks_running() > 0; ++i) usleep(1000);
+    return shim_tasks_running() == 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "sdmmc_cmd.h"
+
+typedef struct
+{
+    gpio_num_t gpio_miso;
+    gpio_num_t gpio_mosi;
+    gpio_num_t gpio_sck;
+    gpio_num_t gpio_cs;
+    int dma_channel;
+} sdspi_slot_config_t;
+
+#define SDSPI_HOST_DEFAULT() { .slot = HSPI_HOST, .max_freq_khz = SDMMC_FREQ_DEFAULT }
+#define SDSPI_SLOT_CONFIG_DEFAULT() { .dma_channel = 1 }
+
+esp_err_t sdspi_host_init();
+esp_err_t sdspi_host_init_slot(int slot, const sdspi_slot_config_t* slot_config);
+esp_err_t sdspi_host_deinit();
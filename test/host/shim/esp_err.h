@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Host stand-ins for the ESP-IDF APIs used by the modules under test. Only
+// what those modules call is declared; behaviour lives in shim.c.
+
+typedef int esp_err_t;
+
+#define ESP_OK (0)
+#define ESP_FAIL (-1)
+#define ESP_ERR_NO_MEM (0x101)
+#define ESP_ERR_INVALID_STATE (0x103)
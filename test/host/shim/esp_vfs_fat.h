@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "driver/sdspi_host.h"
+
+typedef struct
+{
+    bool format_if_mount_failed;
+    int max_files;
+} esp_vfs_fat_sdmmc_mount_config_t;
+
+esp_err_t esp_vfs_fat_sdmmc_mount(const char* base_path, const sdmmc_host_t* host_config,
+    const void* slot_config, const esp_vfs_fat_sdmmc_mount_config_t* mount_config,
+    sdmmc_card_t** out_card);
+esp_err_t esp_vfs_fat_sdmmc_unmount();
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+// The FatFs R0.12 fields odroid_sdcard reads to find a file's clusters
+typedef uint32_t DWORD;
+typedef uint16_t WORD;
+typedef uint8_t BYTE;
+typedef DWORD FSIZE_t;
+
+#define _MIN_SS (512)
+#define _MAX_SS (4096)
+
+typedef struct
+{
+    WORD ssize;
+    WORD csize;
+    DWORD database;
+} FATFS;
+
+typedef struct
+{
+    FATFS* fs;
+    DWORD sclust;
+    FSIZE_t objsize;
+} _FDID;
+
+typedef struct
+{
+    _FDID obj;
+    FSIZE_t fptr;
+    DWORD clust;
+    int shim_index;
+} FIL;
+
+typedef enum
+{
+    FR_OK = 0,
+    FR_DISK_ERR,
+    FR_NO_FILE = 4
+} FRESULT;
+
+#define FA_READ (0x01)
+
+#define f_size(fp) ((fp)->obj.objsize)
+
+FRESULT f_open(FIL* fp, const char* path, BYTE mode);
+FRESULT f_lseek(FIL* fp, FSIZE_t ofs);
+FRESULT f_close(FIL* fp);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+
+#define HSPI_HOST (1)
+
+#define SDMMC_FREQ_PROBING (400)
+#define SDMMC_FREQ_DEFAULT (20000)
+#define SDMMC_FREQ_HIGHSPEED (40000)
+
+typedef struct
+{
+    int slot;
+    int max_freq_khz;
+} sdmmc_host_t;
+
+typedef struct
+{
+    int mfg_id;
+    int oem_id;
+    char name[8];
+    int revision;
+    int serial;
+    int date;
+} sdmmc_cid_t;
+
+typedef struct
+{
+    sdmmc_host_t host;
+    sdmmc_cid_t cid;
+} sdmmc_card_t;
+
+esp_err_t sdmmc_card_init(const sdmmc_host_t* config, sdmmc_card_t* card);
+esp_err_t sdmmc_read_sectors(sdmmc_card_t* card, void* dst, size_t start_sector, size_t sector_count);
@@ -0,0 +1,609 @@
+#include "shim.h"
+
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_vfs_fat.h"
+#include "driver/sdspi_host.h"
+#include "ff.h"
+#include "nvs.h"
+#include "rom/crc.h"
+#include "soc/soc_memory_layout.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "odroid_spi_bus.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+// Fake FAT volume: 2 KB clusters, cluster 2 at sector 64
+#define SECTOR_SIZE (512)
+#define CLUSTER_SECTORS (4)
+#define CLUSTER_SIZE (SECTOR_SIZE * CLUSTER_SECTORS)
+#define DATA_SECTOR (64)
+#define FILE_MAX (256)
+#define NVS_MAX (16)
+#define MOUNT_LOG_MAX (16)
+
+typedef struct
+{
+    char name[64];
+    size_t size;
+    DWORD* clusters;
+    int cluster_count;
+} shim_file;
+
+static FATFS volume = { .ssize = SECTOR_SIZE, .csize = CLUSTER_SECTORS, .database = DATA_SECTOR };
+static uint8_t* image;
+static size_t image_sectors;
+static DWORD next_cluster;
+static shim_file files[FILE_MAX];
+static int file_count;
+
+static sdmmc_card_t card = { .cid = { .mfg_id = 3, .name = "SHIM", .serial = 1234 } };
+
+static struct
+{
+    char key[16];
+    uint32_t value;
+} nvs[NVS_MAX];
+static int nvs_count;
+
+static int card_max_khz;
+static bool identify_fails;
+static bool host_ready;
+static int mount_log[MOUNT_LOG_MAX];
+static int mount_log_count;
+
+static bool dma_capable = true;
+static int reads_before_failure = -1;
+static long sector_reads;
+static int bus_depth;
+static int tasks_running;
+static pthread_mutex_t counter_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+void shim_reset()
+{
+    for (int i = 0; i < file_count; ++i)
+    {
+        free(files[i].clusters);
+    }
+    file_count = 0;
+
+    free(image);
+    image = NULL;
+    image_sectors = 0;
+    next_cluster = 2;
+
+    nvs_count = 0;
+    card_max_khz = 0;
+    identify_fails = false;
+    mount_log_count = 0;
+    dma_capable = true;
+    reads_before_failure = -1;
+}
+
+static void image_grow(size_t sectors)
+{
+    if (sectors <= image_sectors) return;
+
+    image = realloc(image, sectors * SECTOR_SIZE);
+    if (!image) abort();
+
+    memset(image + image_sectors * SECTOR_SIZE, 0, (sectors - image_sectors) * SECTOR_SIZE);
+    image_sectors = sectors;
+}
+
+void shim_fat_add(const char* name, const void* data, size_t size, bool fragmented)
+{
+    if (file_count == FILE_MAX || strlen(name) >= sizeof(files[0].name)) abort();
+
+    shim_file* file = &files[file_count++];
+    strcpy(file->name, name);
+    file->size = size;
+    file->cluster_count = (size + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+    file->clusters = calloc(file->cluster_count + 1, sizeof(DWORD));
+    if (!file->clusters) abort();
+
+    for (int i = 0; i < file->cluster_count; ++i)
+    {
+        DWORD cluster = next_cluster++;
+        if (fragmented) ++next_cluster;
+
+        file->clusters[i] = cluster;
+
+        size_t sector = DATA_SECTOR + (cluster - 2) * CLUSTER_SECTORS;
+        image_grow(sector + CLUSTER_SECTORS);
+
+        size_t offset = (size_t)i * CLUSTER_SIZE;
+        size_t length = size - offset;
+        if (length > CLUSTER_SIZE) length = CLUSTER_SIZE;
+        memcpy(image + sector * SECTOR_SIZE, (const uint8_t*)data + offset, length);
+    }
+}
+
+void shim_set_dma_capable(bool value)
+{
+    dma_capable = value;
+}
+
+void shim_fail_sector_reads_after(int count)
+{
+    reads_before_failure = count;
+}
+
+void shim_set_card_max_khz(int max_khz)
+{
+    card_max_khz = max_khz;
+}
+
+void shim_set_identify_fails(bool fails)
+{
+    identify_fails = fails;
+}
+
+int shim_mount_clocks_take(int* out_khz, int max)
+{
+    int count = mount_log_count < max ? mount_log_count : max;
+    memcpy(out_khz, mount_log, count * sizeof(int));
+    mount_log_count = 0;
+    return count;
+}
+
+int shim_bus_depth()
+{
+    pthread_mutex_lock(&counter_lock);
+    int result = bus_depth;
+    pthread_mutex_unlock(&counter_lock);
+    return result;
+}
+
+int shim_tasks_running()
+{
+    pthread_mutex_lock(&counter_lock);
+    int result = tasks_running;
+    pthread_mutex_unlock(&counter_lock);
+    return result;
+}
+
+long shim_sector_reads()
+{
+    return sector_reads;
+}
+
+
+// ESP-IDF
+
+int64_t esp_timer_get_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void* heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return malloc(size);
+}
+
+bool esp_ptr_dma_capable(const void* p)
+{
+    (void)p;
+    return dma_capable;
+}
+
+uint32_t crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+
+    return ~crc;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode open_mode, nvs_handle* out_handle)
+{
+    (void)name;
+    (void)open_mode;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle handle)
+{
+    (void)handle;
+}
+
+esp_err_t nvs_commit(nvs_handle handle)
+{
+    (void)handle;
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_u32(nvs_handle handle, const char* key, uint32_t* out_value)
+{
+    (void)handle;
+    for (int i = 0; i < nvs_count; ++i)
+    {
+        if (strcmp(nvs[i].key, key) == 0)
+        {
+            *out_value = nvs[i].value;
+            return ESP_OK;
+        }
+    }
+
+    return ESP_FAIL;
+}
+
+esp_err_t nvs_set_u32(nvs_handle handle, const char* key, uint32_t value)
+{
+    (void)handle;
+    for (int i = 0; i < nvs_count; ++i)
+    {
+        if (strcmp(nvs[i].key, key) == 0)
+        {
+            nvs[i].value = value;
+            return ESP_OK;
+        }
+    }
+
+    if (nvs_count == NVS_MAX || strlen(key) >= sizeof(nvs[0].key)) return ESP_FAIL;
+
+    strcpy(nvs[nvs_count].key, key);
+    nvs[nvs_count].value = value;
+    ++nvs_count;
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_fat_sdmmc_mount(const char* base_path, const sdmmc_host_t* host_config,
+    const void* slot_config, const esp_vfs_fat_sdmmc_mount_config_t* mount_config,
+    sdmmc_card_t** out_card)
+{
+    (void)base_path;
+    (void)slot_config;
+    (void)mount_config;
+
+    if (mount_log_count < MOUNT_LOG_MAX) mount_log[mount_log_count++] = host_config->max_freq_khz;
+    if (card_max_khz && host_config->max_freq_khz > card_max_khz) return ESP_FAIL;
+
+    card.host = *host_config;
+    *out_card = &card;
+    return ESP_OK;
+}
+
+esp_err_t sdspi_host_init()
+{
+    if (host_ready) abort();
+
+    host_ready = true;
+    return ESP_OK;
+}
+
+esp_err_t sdspi_host_init_slot(int slot, const sdspi_slot_config_t* slot_config)
+{
+    (void)slot;
+    (void)slot_config;
+    return host_ready ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t sdspi_host_deinit()
+{
+    host_ready = false;
+    return ESP_OK;
+}
+
+// Identification must stay at the probing clock
+esp_err_t sdmmc_card_init(const sdmmc_host_t* config, sdmmc_card_t* out_card)
+{
+    if (!host_ready || config->max_freq_khz > SDMMC_FREQ_PROBING) abort();
+    if (identify_fails) return ESP_FAIL;
+
+    memset(out_card, 0, sizeof(*out_card));
+    out_card->host = *config;
+    out_card->cid = card.cid;
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_fat_sdmmc_unmount()
+{
+    return ESP_OK;
+}
+
+esp_err_t sdmmc_read_sectors(sdmmc_card_t* read_card, void* dst, size_t start_sector, size_t sector_count)
+{
+    if (read_card != &card) abort();
+
+    ++sector_reads;
+
+    if (reads_before_failure == 0) return ESP_FAIL;
+    if (reads_before_failure > 0) --reads_before_failure;
+
+    // Sectors past the image read as zero, like unused card space
+    image_grow(start_sector + sector_count);
+    memcpy(dst, image + start_sector * SECTOR_SIZE, sector_count * SECTOR_SIZE);
+    return ESP_OK;
+}
+
+
+// FATFS
+
+FRESULT f_open(FIL* fp, const char* path, BYTE mode)
+{
+    (void)mode;
+    if (strncmp(path, "0:", 2) != 0) return FR_NO_FILE;
+
+    for (int i = 0; i < file_count; ++i)
+    {
+        if (strcmp(files[i].name, path + 2) == 0)
+        {
+            memset(fp, 0, sizeof(*fp));
+            fp->obj.fs = &volume;
+            fp->obj.sclust = files[i].size ? files[i].clusters[0] : 0;
+            fp->obj.objsize = files[i].size;
+            fp->clust = fp->obj.sclust;
+            fp->shim_index = i;
+            return FR_OK;
+        }
+    }
+
+    return FR_NO_FILE;
+}
+
+// Like FatFs, leaves clust on the cluster holding the byte before 'ofs'
+FRESULT f_lseek(FIL* fp, FSIZE_t ofs)
+{
+    const shim_file* file = &files[fp->shim_index];
+    if (ofs > file->size) ofs = file->size;
+
+    fp->fptr = ofs;
+    fp->clust = (ofs == 0) ? file->clusters[0] : file->clusters[(ofs - 1) / CLUSTER_SIZE];
+    return FR_OK;
+}
+
+FRESULT f_close(FIL* fp)
+{
+    (void)fp;
+    return FR_OK;
+}
+
+
+// odroid_spi_bus
+
+void odroid_spi_bus_init()
+{
+}
+
+void odroid_spi_bus_acquire(odroid_spi_device device)
+{
+    (void)device;
+    pthread_mutex_lock(&counter_lock);
+    ++bus_depth;
+    pthread_mutex_unlock(&counter_lock);
+}
+
+void odroid_spi_bus_release(odroid_spi_device device)
+{
+    (void)device;
+    pthread_mutex_lock(&counter_lock);
+    if (--bus_depth < 0) abort();
+    pthread_mutex_unlock(&counter_lock);
+}
+
+
+// FreeRTOS
+
+struct shim_queue
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint8_t* items;
+    UBaseType_t item_size;
+    UBaseType_t length;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+typedef struct
+{
+    TaskFunction_t function;
+    void* parameters;
+} shim_task;
+
+// Waits on 'changed' until 'ready' or the tick timeout passes
+static bool queue_wait(struct shim_queue* queue, bool (*ready)(const struct shim_queue*), TickType_t ticks)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    long long ns = deadline.tv_nsec + (long long)ticks * portTICK_PERIOD_MS * 1000000;
+    deadline.tv_sec += ns / 1000000000;
+    deadline.tv_nsec = ns % 1000000000;
+
+    while (!ready(queue))
+    {
+        if (ticks == 0) return false;
+
+        if (ticks == portMAX_DELAY)
+        {
+            pthread_cond_wait(&queue->changed, &queue->lock);
+        }
+        else if (pthread_cond_timedwait(&queue->changed, &queue->lock, &deadline) == ETIMEDOUT)
+        {
+            return ready(queue);
+        }
+    }
+
+    return true;
+}
+
+static bool queue_has_space(const struct shim_queue* queue)
+{
+    return queue->count < queue->length;
+}
+
+static bool queue_has_item(const struct shim_queue* queue)
+{
+    return queue->count > 0;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct shim_queue* queue = calloc(1, sizeof(struct shim_queue));
+    if (!queue) return NULL;
+
+    queue->items = calloc(length, item_size ? item_size : 1);
+    if (!queue->items)
+    {
+        free(queue);
+        return NULL;
+    }
+
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    queue->item_size = item_size;
+    queue->length = length;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    pthread_cond_destroy(&queue->changed);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->items);
+    free(queue);
+}
+
+static BaseType_t queue_send(QueueHandle_t queue, const void* item, TickType_t ticks, bool front)
+{
+    pthread_mutex_lock(&queue->lock);
+
+    BaseType_t result = pdFAIL;
+    if (queue_wait(queue, queue_has_space, ticks))
+    {
+        UBaseType_t slot;
+        if (front)
+        {
+            queue->head = (queue->head + queue->length - 1) % queue->length;
+            slot = queue->head;
+        }
+        else
+        {
+            slot = (queue->head + queue->count) % queue->length;
+        }
+
+        if (queue->item_size) memcpy(queue->items + slot * queue->item_size, item, queue->item_size);
+        ++queue->count;
+
+        pthread_cond_broadcast(&queue->changed);
+        result = pdPASS;
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    return result;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    return queue_send(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    return queue_send(queue, item, ticks, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks)
+{
+    pthread_mutex_lock(&queue->lock);
+
+    BaseType_t result = pdFAIL;
+    if (queue_wait(queue, queue_has_item, ticks))
+    {
+        if (queue->item_size) memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        --queue->count;
+
+        pthread_cond_broadcast(&queue->changed);
+        result = pdTRUE;
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    return result;
+}
+
+static void* task_main(void* arg)
+{
+    shim_task task = *(shim_task*)arg;
+    free(arg);
+
+    task.function(task.parameters);
+
+    // FreeRTOS tasks must not return
+    abort();
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stack_depth,
+    void* parameters, UBaseType_t priority, TaskHandle_t* out_handle, BaseType_t core)
+{
+    (void)name;
+    (void)stack_depth;
+    (void)priority;
+    (void)core;
+
+    shim_task* task = malloc(sizeof(shim_task));
+    if (!task) return pdFAIL;
+
+    task->function = function;
+    task->parameters = parameters;
+
+    pthread_mutex_lock(&counter_lock);
+    ++tasks_running;
+    pthread_mutex_unlock(&counter_lock);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    pthread_t thread;
+    int err = pthread_create(&thread, &attr, task_main, task);
+    pthread_attr_destroy(&attr);
+
+    if (err != 0)
+    {
+        free(task);
+        pthread_mutex_lock(&counter_lock);
+        --tasks_running;
+        pthread_mutex_unlock(&counter_lock);
+        return pdFAIL;
+    }
+
+    if (out_handle) *out_handle = (TaskHandle_t)task;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // Only self deletion is used
+    if (task != NULL) abort();
+
+    pthread_mutex_lock(&counter_lock);
+    --tasks_running;
+    pthread_mutex_unlock(&counter_lock);
+
+    pthread_exit(NULL);
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    (void)task;
+    return 5;
+}
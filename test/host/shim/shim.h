@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Controls and counters for the host shim (see shim.c).
+
+// Clears the fake FAT volume, the NVS store, the card behaviour and the
+// fault injection.
+void shim_reset();
+
+// Adds a file to the fake FAT volume, seen by FATFS as "0:<name>". Its
+// clusters follow each other, or with 'fragmented' leave a hole after
+// each one. The same data must be written to the host directory used as
+// the mount point for the VFS side.
+void shim_fat_add(const char* name, const void* data, size_t size, bool fragmented);
+
+// What esp_ptr_dma_capable answers, to pick internal RAM or SPIRAM paths
+void shim_set_dma_capable(bool dma_capable);
+
+// sdmmc_read_sectors fails once this many more calls have succeeded;
+// negative never fails
+void shim_fail_sector_reads_after(int count);
+
+// The card fails to mount above this clock; 0 is no limit
+void shim_set_card_max_khz(int max_khz);
+
+// sdmmc_card_init fails, so the card can only be identified by mounting
+void shim_set_identify_fails(bool fails);
+
+// Clocks of the mount attempts since shim_reset or the last call, oldest
+// first. Returns how many there were.
+int shim_mount_clocks_take(int* out_khz, int max);
+
+int shim_bus_depth();      // SD bus acquisitions not yet released
+int shim_tasks_running();  // tasks created and not yet deleted
+long shim_sector_reads();  // sdmmc_read_sectors calls
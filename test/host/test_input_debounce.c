@@ -0,0 +1,322 @@
+#include "input_debounce.h"
+#include "check.h"
+#include "dpad_traces.h"
+
+#include <stdint.h>
+
+
+// Sample spacing enforced by the input task (ACTIVE_POLL_MS)
+#define SAMPLE_INTERVAL_US (10 * 1000)
+
+// A contact signal over time: 'level' from 'start_us' until the next edge
+typedef struct
+{
+    int64_t start_us;
+    uint8_t level;
+} edge_t;
+
+static uint8_t trace_level(const edge_t* trace, int count, int64_t t)
+{
+    uint8_t level = 0;
+    for (int i = 0; i < count && trace[i].start_us <= t; ++i)
+    {
+        level = trace[i].level;
+    }
+
+    return level;
+}
+
+// Samples the trace every 'interval_us' up to 'end_us' and counts the
+// debounced transitions.
+static int replay(const edge_t* trace, int count, int64_t end_us, int64_t interval_us,
+    uint8_t window, uint8_t* out_final)
+{
+    input_debounce_t debounce;
+    input_debounce_init(&debounce, window, 0);
+
+    int transitions = 0;
+    for (int64_t t = 0; t <= end_us; t += interval_us)
+    {
+        if (input_debounce_update(&debounce, trace_level(trace, count, t))) ++transitions;
+    }
+
+    *out_final = debounce.value;
+    return transitions;
+}
+
+
+static void test_init()
+{
+    input_debounce_t debounce;
+
+    input_debounce_init(&debounce, 3, 0);
+    CHECK_EQ(debounce.value, 0);
+    CHECK(input_debounce_is_settled(&debounce));
+
+    input_debounce_init(&debounce, 3, 1);
+    CHECK_EQ(debounce.value, 1);
+    CHECK_EQ(debounce.count, 3);
+    CHECK(input_debounce_is_settled(&debounce));
+
+    // A zero window behaves as one
+    input_debounce_init(&debounce, 0, 0);
+    CHECK_EQ(debounce.window, 1);
+    CHECK(input_debounce_update(&debounce, 1));
+}
+
+static void test_window()
+{
+    input_debounce_t debounce;
+    input_debounce_init(&debounce, 3, 0);
+
+    // Needs 'window' consecutive samples to change
+    CHECK(!input_debounce_update(&debounce, 1));
+    CHECK(!input_debounce_is_settled(&debounce));
+    CHECK(!input_debounce_update(&debounce, 1));
+    CHECK(input_debounce_update(&debounce, 1));
+    CHECK_EQ(debounce.value, 1);
+    CHECK(input_debounce_is_settled(&debounce));
+
+    // Saturates, so one low sample does not release
+    CHECK(!input_debounce_update(&debounce, 1));
+    CHECK(!input_debounce_update(&debounce, 0));
+    CHECK_EQ(debounce.value, 1);
+    CHECK(!input_debounce_update(&debounce, 1));
+
+    // Integrates: alternating samples never reach either end
+    input_debounce_init(&debounce, 3, 0);
+    for (int i = 0; i < 100; ++i)
+    {
+        CHECK(!input_debounce_update(&debounce, i & 1));
+    }
+    CHECK_EQ(debounce.value, 0);
+}
+
+static void test_bounce_trace()
+{
+    // Press at 0 with 5 ms of bounce, release at 200 ms with 5 ms of bounce
+    edge_t press[32];
+    int count = 0;
+    for (int64_t t = 0; t < 5000; t += 500)
+    {
+        press[count].start_us = t;
+        press[count].level = (t / 500) % 2 == 0;
+        ++count;
+    }
+    press[count++] = (edge_t){ 5000, 1 };
+    for (int64_t t = 200000; t < 205000; t += 500)
+    {
+        press[count].start_us = t;
+        press[count].level = (t / 500) % 2 != 0;
+        ++count;
+    }
+    press[count++] = (edge_t){ 205000, 0 };
+
+    uint8_t final;
+    CHECK_EQ(replay(press, count, 300000, SAMPLE_INTERVAL_US, 2, &final), 2);
+    CHECK_EQ(final, 0);
+
+    CHECK_EQ(replay(press, count, 300000, SAMPLE_INTERVAL_US, 3, &final), 2);
+    CHECK_EQ(final, 0);
+}
+
+static void test_glitch()
+{
+    // A 3 ms spike on an idle line
+    const edge_t glitch[] = { { 41000, 1 }, { 44000, 0 } };
+    uint8_t final;
+
+    // At the enforced spacing at most one sample can see it
+    CHECK_EQ(replay(glitch, 2, 200000, SAMPLE_INTERVAL_US, 2, &final), 0);
+    CHECK_EQ(final, 0);
+
+    // Samples taken back to back after an edge wake would accept it as a
+    // press, which is why the input task keeps the spacing.
+    CHECK(replay(glitch, 2, 200000, 100, 2, &final) > 0);
+}
+
+static void test_axis_classify()
+{
+    const input_axis_thresholds_t thresholds = { .high = 3072, .low = 1024 };
+
+    CHECK_EQ(input_axis_classify(&thresholds, 0), INPUT_AXIS_NONE);
+    CHECK_EQ(input_axis_classify(&thresholds, 1024), INPUT_AXIS_NONE);
+    CHECK_EQ(input_axis_classify(&thresholds, 1025), INPUT_AXIS_LOW);
+    CHECK_EQ(input_axis_classify(&thresholds, 3072), INPUT_AXIS_LOW);
+    CHECK_EQ(input_axis_classify(&thresholds, 3073), INPUT_AXIS_HIGH);
+    CHECK_EQ(input_axis_classify(&thresholds, 4095), INPUT_AXIS_HIGH);
+}
+
+static void test_axis_thresholds()
+{
+    input_axis_thresholds_t thresholds = { .high = -1, .low = -1 };
+
+    // Typical ladder readings: rest near 0, one direction mid-scale, the
+    // other at full scale
+    CHECK(input_axis_thresholds_from_samples(&thresholds, 100, 4095, 1900));
+    CHECK_EQ(thresholds.high, (4095 + 1900) / 2);
+    CHECK_EQ(thresholds.low, (1900 + 100) / 2);
+
+    // The sampled positions classify as themselves
+    CHECK_EQ(input_axis_classify(&thresholds, 100), INPUT_AXIS_NONE);
+    CHECK_EQ(input_axis_classify(&thresholds, 1900), INPUT_AXIS_LOW);
+    CHECK_EQ(input_axis_classify(&thresholds, 4095), INPUT_AXIS_HIGH);
+
+    // Positions too close together, or in the wrong order, are rejected and
+    // leave the output alone
+    input_axis_thresholds_t untouched = { .high = 7, .low = 5 };
+    CHECK(!input_axis_thresholds_from_samples(&untouched, 100, 4095, 300));
+    CHECK(!input_axis_thresholds_from_samples(&untouched, 100, 2000, 1900));
+    CHECK(!input_axis_thresholds_from_samples(&untouched, 100, 1900, 4095));
+    CHECK(!input_axis_thresholds_from_samples(&untouched, 2000, 4095, 1900));
+    CHECK_EQ(untouched.high, 7);
+    CHECK_EQ(untouched.low, 5);
+
+    // Exactly the minimum separation is accepted
+    CHECK(input_axis_thresholds_from_samples(&thresholds, 0, 512, 256));
+}
+
+// What the input task makes of a D-pad trace: each sample classified with
+// the calibration, then integrated per direction
+typedef struct
+{
+    int presses[4];     // debounced presses per direction, bit order
+    int raw_samples[4]; // samples classified as each direction
+    int first_press;    // sample of the first debounced press, -1 if none
+    uint8_t held;       // directions still held at the end
+} dpad_replay_t;
+
+static const input_axis_thresholds_t stock = { .high = 2048 + 1024, .low = 1024 };
+
+#define TRACE_LENGTH(trace) ((int)(sizeof(trace) / sizeof(trace[0])))
+
+static dpad_replay_t replay_dpad(const input_trace_sample_t* trace, int count,
+    const input_axis_thresholds_t* x, const input_axis_thresholds_t* y)
+{
+    input_debounce_t debounce[4];
+    for (int d = 0; d < 4; ++d)
+    {
+        input_debounce_init(&debounce[d], INPUT_DEBOUNCE_DPAD_WINDOW, 0);
+    }
+
+    dpad_replay_t result = { .first_press = -1 };
+
+    for (int s = 0; s < count; ++s)
+    {
+        uint8_t bits = input_dpad_classify(x, y, trace[s].x, trace[s].y);
+
+        for (int d = 0; d < 4; ++d)
+        {
+            uint8_t raw = (bits >> d) & 1;
+            result.raw_samples[d] += raw;
+
+            if (input_debounce_update(&debounce[d], raw) && debounce[d].value)
+            {
+                ++result.presses[d];
+                if (result.first_press < 0) result.first_press = s;
+            }
+        }
+    }
+
+    for (int d = 0; d < 4; ++d)
+    {
+        if (debounce[d].value) result.held |= 1 << d;
+    }
+
+    return result;
+}
+
+static int direction_index(uint8_t bit)
+{
+    int index = 0;
+    while (!(bit & (1 << index))) ++index;
+    return index;
+}
+
+static void test_replay_rest()
+{
+    dpad_replay_t result = replay_dpad(trace_rest, TRACE_LENGTH(trace_rest), &stock, &stock);
+
+    CHECK_EQ(result.first_press, -1);
+    CHECK_EQ(result.held, 0);
+}
+
+// Held from sample 20, released 30 samples later
+static void check_direction(const input_trace_sample_t* trace, int count, uint8_t direction)
+{
+    dpad_replay_t result = replay_dpad(trace, count, &stock, &stock);
+    const int index = direction_index(direction);
+
+    for (int d = 0; d < 4; ++d)
+    {
+        CHECK_EQ(result.presses[d], (d == index));
+    }
+    CHECK_EQ(result.held, 0);
+
+    // Within the window plus the sample the press rises through
+    CHECK(result.first_press >= 20 && result.first_press <= 20 + INPUT_DEBOUNCE_DPAD_WINDOW);
+}
+
+static void test_replay_directions()
+{
+    check_direction(trace_left, TRACE_LENGTH(trace_left), INPUT_DPAD_LEFT);
+    check_direction(trace_right, TRACE_LENGTH(trace_right), INPUT_DPAD_RIGHT);
+    check_direction(trace_up, TRACE_LENGTH(trace_up), INPUT_DPAD_UP);
+    check_direction(trace_down, TRACE_LENGTH(trace_down), INPUT_DPAD_DOWN);
+
+    // The transits and the dropout are in the raw classification, and only
+    // the integration hides them
+    dpad_replay_t left = replay_dpad(trace_left, TRACE_LENGTH(trace_left), &stock, &stock);
+    CHECK(left.raw_samples[direction_index(INPUT_DPAD_RIGHT)] > 0);
+
+    const input_trace_sample_t dropout = trace_down[20 + 1 + 14];
+    CHECK_EQ(input_dpad_classify(&stock, &stock, dropout.x, dropout.y), 0);
+}
+
+static int mean_x(const input_trace_sample_t* trace, int first, int count)
+{
+    int sum = 0;
+    for (int i = first; i < first + count; ++i) sum += trace[i].x;
+    return sum / count;
+}
+
+static void test_replay_worn()
+{
+    const int count = TRACE_LENGTH(trace_worn);
+    const int right = direction_index(INPUT_DPAD_RIGHT);
+    const int left = direction_index(INPUT_DPAD_LEFT);
+
+    // The stock thresholds read the drifted rest position as RIGHT long
+    // before it is pressed (sample 120)
+    dpad_replay_t result = replay_dpad(trace_worn, count, &stock, &stock);
+    CHECK(result.first_press >= 0 && result.first_press < 120);
+    CHECK(result.presses[right] > 0);
+
+    // Calibrated from the positions as the calibration screen averages
+    // them: rest at 80-119, RIGHT held at 121-150, LEFT held at 184-213
+    input_axis_thresholds_t x;
+    CHECK(input_axis_thresholds_from_samples(&x,
+        mean_x(trace_worn, 80, 40), mean_x(trace_worn, 184, 30), mean_x(trace_worn, 121, 30)));
+
+    result = replay_dpad(trace_worn, count, &x, &stock);
+    CHECK_EQ(result.presses[right], 1);
+    CHECK_EQ(result.presses[left], 1);
+    CHECK(result.first_press >= 120 && result.first_press <= 120 + INPUT_DEBOUNCE_DPAD_WINDOW);
+    CHECK_EQ(result.held, 0);
+}
+
+
+int main()
+{
+    test_init();
+    test_window();
+    test_bounce_trace();
+    test_glitch();
+    test_axis_classify();
+    test_axis_thresholds();
+    test_replay_rest();
+    test_replay_directions();
+    test_replay_worn();
+
+    return CHECK_DONE();
+}
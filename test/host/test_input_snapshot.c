@@ -0,0 +1,139 @@
+#include "input_snapshot.h"
+#include "check.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+
+
+#define WRITER_PUBLISHES (2000000)
+#define READER_COUNT (3)
+
+#define ALL_BUTTONS ((1u << INPUT_SNAPSHOT_MAX_BUTTONS) - 1)
+
+static input_snapshot_lock_t lock;
+static volatile bool writer_done;
+
+typedef struct
+{
+    long reads;
+    long torn;
+    long backwards;
+} reader_result_t;
+
+
+static void test_publish()
+{
+    input_snapshot_t snapshot;
+
+    input_snapshot_init(&lock);
+    input_snapshot_read(&lock, &snapshot);
+    CHECK_EQ(snapshot.sequence, 0);
+    CHECK_EQ(snapshot.buttons, 0);
+
+    input_snapshot_publish(&lock, 0x5, 100);
+    input_snapshot_read(&lock, &snapshot);
+    CHECK_EQ(snapshot.sequence, 2);
+    CHECK_EQ(snapshot.buttons, 0x5);
+    CHECK_EQ(snapshot.last_transition_us[0], 100);
+    CHECK_EQ(snapshot.last_transition_us[1], 0);
+    CHECK_EQ(snapshot.last_transition_us[2], 100);
+
+    // Only changed bits are stamped
+    input_snapshot_publish(&lock, 0x6, 200);
+    input_snapshot_read(&lock, &snapshot);
+    CHECK_EQ(snapshot.buttons, 0x6);
+    CHECK_EQ(snapshot.last_transition_us[0], 200);
+    CHECK_EQ(snapshot.last_transition_us[1], 200);
+    CHECK_EQ(snapshot.last_transition_us[2], 100);
+
+    // An unchanged mask is not a new version
+    input_snapshot_publish(&lock, 0x6, 300);
+    input_snapshot_read(&lock, &snapshot);
+    CHECK_EQ(snapshot.sequence, 4);
+    CHECK_EQ(snapshot.last_transition_us[1], 200);
+    CHECK_EQ(input_snapshot_buttons(&lock), 0x6);
+}
+
+// Every publish flips all buttons, so each version has all transition times
+// equal to its step number and a mask implied by its parity. Any mix of two
+// versions breaks that.
+static void* writer(void* arg)
+{
+    (void)arg;
+
+    for (int64_t step = 1; step <= WRITER_PUBLISHES; ++step)
+    {
+        input_snapshot_publish(&lock, (step & 1) ? ALL_BUTTONS : 0, step);
+    }
+
+    writer_done = true;
+    return NULL;
+}
+
+static void* reader(void* arg)
+{
+    reader_result_t* result = (reader_result_t*)arg;
+    int64_t last_step = 0;
+
+    while (!writer_done)
+    {
+        input_snapshot_t snapshot;
+        input_snapshot_read(&lock, &snapshot);
+        ++result->reads;
+
+        int64_t step = snapshot.last_transition_us[0];
+        bool consistent = (snapshot.sequence == (uint32_t)(step * 2)) &&
+            (snapshot.buttons == ((step & 1) ? ALL_BUTTONS : 0));
+        for (int i = 1; i < INPUT_SNAPSHOT_MAX_BUTTONS; ++i)
+        {
+            if (snapshot.last_transition_us[i] != step) consistent = false;
+        }
+
+        if (!consistent) ++result->torn;
+        if (step < last_step) ++result->backwards;
+        last_step = step;
+    }
+
+    return NULL;
+}
+
+static void test_concurrent()
+{
+    input_snapshot_init(&lock);
+    writer_done = false;
+
+    pthread_t readers[READER_COUNT];
+    reader_result_t results[READER_COUNT] = {{0}};
+    for (int i = 0; i < READER_COUNT; ++i)
+    {
+        CHECK_EQ(pthread_create(&readers[i], NULL, reader, &results[i]), 0);
+    }
+
+    pthread_t writer_thread;
+    CHECK_EQ(pthread_create(&writer_thread, NULL, writer, NULL), 0);
+
+    pthread_join(writer_thread, NULL);
+
+    for (int i = 0; i < READER_COUNT; ++i)
+    {
+        pthread_join(readers[i], NULL);
+
+        printf("reader %d: %ld reads, %ld torn, %ld backwards\n",
+            i, results[i].reads, results[i].torn, results[i].backwards);
+        CHECK_EQ(results[i].torn, 0);
+        CHECK_EQ(results[i].backwards, 0);
+    }
+
+    input_snapshot_t snapshot;
+    input_snapshot_read(&lock, &snapshot);
+    CHECK_EQ(snapshot.sequence, WRITER_PUBLISHES * 2);
+}
+
+
+int main()
+{
+    test_publish();
+    test_concurrent();
+
+    return CHECK_DONE();
+}
@@ -0,0 +1,193 @@
+#include "partition_plan.h"
+#include "check.h"
+
+#include <string.h>
+
+
+#define REGION_START (0x110000)
+#define REGION_END (0x1000000)
+
+static partition_plan_entry_t entry(const char* label, uint32_t offset, uint32_t size)
+{
+    partition_plan_entry_t result = { .type = 0, .subtype = 0x10, .offset = offset, .size = size };
+    memcpy(result.label, label, strlen(label)); // labels here are shorter than the field
+    return result;
+}
+
+static const partition_plan_entry_t current[] = {
+    { .type = 0, .subtype = 0x10, .label = "nes", .offset = 0x110000, .size = 0x100000 },
+    { .type = 0, .subtype = 0x10, .label = "gb", .offset = 0x210000, .size = 0x100000 },
+    { .type = 0, .subtype = 0x10, .label = "sms", .offset = 0x310000, .size = 0x100000 },
+};
+#define CURRENT_COUNT (sizeof(current) / sizeof(current[0]))
+
+// Aligned, inside the region and not overlapping each other
+static bool layout_valid(const partition_plan_entry_t* incoming, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        uint32_t end = incoming[i].offset + incoming[i].size;
+        if (incoming[i].offset % PARTITION_PLAN_ALIGN) return false;
+        if (incoming[i].offset < REGION_START || end > REGION_END) return false;
+
+        for (int j = 0; j < i; ++j)
+        {
+            if (incoming[i].offset < incoming[j].offset + incoming[j].size &&
+                incoming[j].offset < end) return false;
+        }
+    }
+
+    return true;
+}
+
+
+static void test_unchanged()
+{
+    partition_plan_entry_t incoming[] = {
+        entry("nes", 0, 0x100000), entry("gb", 0, 0x100000), entry("sms", 0, 0x100000) };
+    bool kept[3];
+
+    CHECK_EQ(partition_plan_layout(current, CURRENT_COUNT, incoming, kept, 3, REGION_START, REGION_END), 3);
+    CHECK_EQ(incoming[0].offset, 0x110000);
+    CHECK_EQ(incoming[1].offset, 0x210000);
+    CHECK_EQ(incoming[2].offset, 0x310000);
+    CHECK(kept[0] && kept[1] && kept[2]);
+}
+
+static void test_resized()
+{
+    // A grown partition moves to the first gap behind the kept ones
+    partition_plan_entry_t grown[] = {
+        entry("nes", 0, 0x180000), entry("gb", 0, 0x100000), entry("sms", 0, 0x100000) };
+    bool kept[3];
+
+    CHECK_EQ(partition_plan_layout(current, CURRENT_COUNT, grown, kept, 3, REGION_START, REGION_END), 2);
+    CHECK_EQ(grown[0].offset, 0x410000);
+    CHECK(!kept[0] && kept[1] && kept[2]);
+    CHECK(layout_valid(grown, 3));
+
+    // A shrunk one fits back into its old place, but its data is new
+    partition_plan_entry_t shrunk[] = {
+        entry("nes", 0, 0x080000), entry("gb", 0, 0x100000), entry("sms", 0, 0x100000) };
+
+    CHECK_EQ(partition_plan_layout(current, CURRENT_COUNT, shrunk, kept, 3, REGION_START, REGION_END), 2);
+    CHECK_EQ(shrunk[0].offset, 0x110000);
+    CHECK(!kept[0] && kept[1] && kept[2]);
+    CHECK(layout_valid(shrunk, 3));
+}
+
+static void test_replaced()
+{
+    partition_plan_entry_t incoming[] = {
+        entry("nes", 0, 0x100000), entry("a26", 0, 0x100000), entry("sms", 0, 0x100000) };
+    bool kept[3];
+
+    CHECK_EQ(partition_plan_layout(current, CURRENT_COUNT, incoming, kept, 3, REGION_START, REGION_END), 2);
+    CHECK_EQ(incoming[1].offset, 0x210000);
+    CHECK(kept[0] && !kept[1] && kept[2]);
+    CHECK(layout_valid(incoming, 3));
+}
+
+static void test_fragmented()
+{
+    // No gap fits the large partition, so everything is packed from the
+    // region start like the old layout
+    partition_plan_entry_t incoming[] = {
+        entry("nes", 0, 0x100000), entry("big", 0, 0xc00000), entry("sms", 0, 0x100000) };
+    bool kept[3];
+
+    CHECK_EQ(partition_plan_layout(current, CURRENT_COUNT, incoming, kept, 3, REGION_START, REGION_END), 1);
+    CHECK_EQ(incoming[0].offset, 0x110000);
+    CHECK_EQ(incoming[1].offset, 0x210000);
+    CHECK_EQ(incoming[2].offset, 0xe10000);
+    CHECK(kept[0] && !kept[1] && !kept[2]);
+    CHECK(layout_valid(incoming, 3));
+}
+
+static void test_edge_cases()
+{
+    bool kept[3];
+
+    partition_plan_entry_t too_big[] = { entry("nes", 0, REGION_END - REGION_START + 1) };
+    CHECK_EQ(partition_plan_layout(current, CURRENT_COUNT, too_big, kept, 1, REGION_START, REGION_END), -1);
+
+    // Empty flash packs in file order, unaligned sizes round up
+    partition_plan_entry_t fresh[] = {
+        entry("nes", 0, 0x180000), entry("gb", 0, 0x0f8000), entry("sms", 0, 0x100000) };
+    CHECK_EQ(partition_plan_layout(NULL, 0, fresh, kept, 3, REGION_START, REGION_END), 0);
+    CHECK_EQ(fresh[0].offset, 0x110000);
+    CHECK_EQ(fresh[1].offset, 0x290000);
+    CHECK_EQ(fresh[2].offset, 0x390000);
+    CHECK(layout_valid(fresh, 3));
+
+    // One existing partition can only be claimed once
+    partition_plan_entry_t twice[] = { entry("nes", 0, 0x100000), entry("nes", 0, 0x100000) };
+    CHECK_EQ(partition_plan_layout(current, CURRENT_COUNT, twice, kept, 2, REGION_START, REGION_END), 1);
+    CHECK(kept[0]);
+    CHECK(!kept[1]);
+    CHECK(layout_valid(twice, 2));
+
+    // Same label but another subtype is a different partition
+    partition_plan_entry_t other[] = { entry("gb", 0, 0x100000) };
+    other[0].subtype = 0x11;
+    CHECK_EQ(partition_plan_layout(current, CURRENT_COUNT, other, kept, 1, REGION_START, REGION_END), 0);
+}
+
+
+static int plan(const char* pattern, partition_plan_range_t* ranges)
+{
+    bool differs[32];
+    int count = strlen(pattern);
+    for (int i = 0; i < count; ++i) differs[i] = (pattern[i] == 'x');
+
+    return partition_plan_erase_ranges(differs, count, ranges);
+}
+
+static void test_erase_ranges()
+{
+    partition_plan_range_t ranges[16];
+
+    CHECK_EQ(plan("........", ranges), 0);
+
+    CHECK_EQ(plan("...x....", ranges), 1);
+    CHECK(ranges[0].first == 3 && ranges[0].count == 1);
+
+    // Adjacent sectors merge
+    CHECK_EQ(plan("x.xx...x", ranges), 3);
+    CHECK(ranges[0].first == 0 && ranges[0].count == 1);
+    CHECK(ranges[1].first == 2 && ranges[1].count == 2);
+    CHECK(ranges[2].first == 7 && ranges[2].count == 1);
+
+    // Half is not most
+    CHECK_EQ(plan("xx..xx..", ranges), 2);
+    CHECK(ranges[0].first == 0 && ranges[0].count == 2);
+    CHECK(ranges[1].first == 4 && ranges[1].count == 2);
+
+    // Most sectors differ: one erase for the whole block
+    CHECK_EQ(plan("xx.xx.x.x", ranges), 1);
+    CHECK(ranges[0].first == 0 && ranges[0].count == 9);
+    CHECK_EQ(plan("xxxxxxxx", ranges), 1);
+    CHECK(ranges[0].first == 0 && ranges[0].count == 8);
+
+    // Short last block of a partition
+    CHECK_EQ(plan("x", ranges), 1);
+    CHECK(ranges[0].first == 0 && ranges[0].count == 1);
+    CHECK_EQ(plan("", ranges), 0);
+
+    // The worst case fits the documented bound
+    CHECK_EQ(plan("x.x.x.x.", ranges), 4);
+    CHECK_EQ(plan("x.x.x.x.x", ranges), 1);
+}
+
+
+int main()
+{
+    test_unchanged();
+    test_resized();
+    test_replaced();
+    test_fragmented();
+    test_edge_cases();
+    test_erase_ranges();
+
+    return CHECK_DONE();
+}
@@ -0,0 +1,192 @@
+#include "partition_table.h"
+#include "check.h"
+
+#include <string.h>
+
+
+static uint8_t raw[PARTITION_TABLE_MAX_LEN];
+static partition_table_t table;
+
+static void put(int index, uint8_t type, uint8_t subtype, uint32_t offset, uint32_t size, const char* label)
+{
+    uint8_t* entry = raw + index * PARTITION_TABLE_ENTRY_SIZE;
+    memset(entry, 0, PARTITION_TABLE_ENTRY_SIZE);
+
+    entry[0] = PARTITION_TABLE_MAGIC & 0xff;
+    entry[1] = PARTITION_TABLE_MAGIC >> 8;
+    entry[2] = type;
+    entry[3] = subtype;
+    for (int i = 0; i < 4; ++i)
+    {
+        entry[4 + i] = offset >> (i * 8);
+        entry[8 + i] = size >> (i * 8);
+    }
+    memcpy(entry + 12, label, strlen(label));
+}
+
+// Stands in for the ROM MD5: the parser only hands the digest function the
+// bytes in front of the MD5 record and compares the result, so any digest
+// that depends on every byte and on the length exercises the same paths.
+static int digest_calls;
+
+static void digest(const void* data, size_t length, uint8_t out[16])
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t hash = 0xcbf29ce484222325ull ^ length;
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        out[i] = hash >> ((i % 8) * 8);
+        if (i == 7) hash = hash * 0x100000001b3ull + 1;
+    }
+
+    ++digest_calls;
+}
+
+static void put_md5(int index)
+{
+    uint8_t* entry = raw + index * PARTITION_TABLE_ENTRY_SIZE;
+    memset(entry, 0xff, PARTITION_TABLE_ENTRY_SIZE);
+
+    entry[0] = PARTITION_TABLE_MAGIC_MD5 & 0xff;
+    entry[1] = PARTITION_TABLE_MAGIC_MD5 >> 8;
+    digest(raw, index * PARTITION_TABLE_ENTRY_SIZE, entry + 16);
+}
+
+// The usual layout: nvs, phy_init, factory and two firmware partitions
+static void build_table()
+{
+    memset(raw, 0xff, sizeof(raw));
+
+    put(0, 1, 0x02, 0x9000, 0x6000, "nvs");
+    put(1, 1, 0x01, 0xf000, 0x1000, "phy_init");
+    put(2, 0, 0x00, 0x10000, 0x100000, "factory");
+    put(3, 0, 0x10, 0x110000, 0x100000, "nes");
+    put(4, 0, 0x11, 0x310000, 0x80000, "gb");
+}
+
+
+static void test_parse()
+{
+    build_table();
+
+    CHECK_EQ(partition_table_parse(&table, raw, sizeof(raw), digest), PARTITION_TABLE_OK);
+    CHECK_EQ(table.count, 5);
+    CHECK(!table.has_md5);
+    CHECK(memcmp(table.raw, raw, sizeof(raw)) == 0);
+
+    const partition_table_entry_t* gb = &table.entries[4];
+    CHECK_EQ(gb->type, 0);
+    CHECK_EQ(gb->subtype, 0x11);
+    CHECK_EQ(gb->offset, 0x310000);
+    CHECK_EQ(gb->size, 0x80000);
+    CHECK(strcmp(gb->label, "gb") == 0);
+    CHECK_EQ(gb->index, 4);
+
+    // A full 16 byte label is still null terminated after parsing
+    put(4, 0, 0x11, 0x310000, 0x80000, "0123456789abcdef");
+    CHECK_EQ(partition_table_parse(&table, raw, sizeof(raw), NULL), PARTITION_TABLE_OK);
+    CHECK(strcmp(table.entries[4].label, "0123456789abcdef") == 0);
+
+    // Shorter input is padded as erased flash
+    build_table();
+    CHECK_EQ(partition_table_parse(&table, raw, 5 * PARTITION_TABLE_ENTRY_SIZE, NULL), PARTITION_TABLE_OK);
+    CHECK_EQ(table.count, 5);
+
+    CHECK_EQ(partition_table_parse(&table, raw, PARTITION_TABLE_ENTRY_SIZE - 1, NULL), PARTITION_TABLE_ERR_LENGTH);
+    CHECK_EQ(partition_table_parse(&table, raw, PARTITION_TABLE_MAX_LEN + 1, NULL), PARTITION_TABLE_ERR_LENGTH);
+
+    raw[2 * PARTITION_TABLE_ENTRY_SIZE] = 0x12;
+    CHECK_EQ(partition_table_parse(&table, raw, sizeof(raw), NULL), PARTITION_TABLE_ERR_MAGIC);
+}
+
+static void test_md5()
+{
+    build_table();
+    put_md5(5);
+
+    digest_calls = 0;
+    CHECK_EQ(partition_table_parse(&table, raw, sizeof(raw), digest), PARTITION_TABLE_OK);
+    CHECK(table.has_md5);
+    CHECK_EQ(table.count, 5);
+    CHECK_EQ(digest_calls, 1);
+
+    // Entries behind the MD5 record are ignored
+    put(6, 0, 0x12, 0x400000, 0x10000, "late");
+    CHECK_EQ(partition_table_parse(&table, raw, sizeof(raw), digest), PARTITION_TABLE_OK);
+    CHECK_EQ(table.count, 5);
+
+    // A changed entry or digest is rejected
+    raw[3 * PARTITION_TABLE_ENTRY_SIZE + 8] ^= 1;
+    CHECK_EQ(partition_table_parse(&table, raw, sizeof(raw), digest), PARTITION_TABLE_ERR_MD5);
+    raw[3 * PARTITION_TABLE_ENTRY_SIZE + 8] ^= 1;
+
+    raw[5 * PARTITION_TABLE_ENTRY_SIZE + 20] ^= 0x80;
+    CHECK_EQ(partition_table_parse(&table, raw, sizeof(raw), digest), PARTITION_TABLE_ERR_MD5);
+
+    // Without a digest function the record is noted but not checked
+    CHECK_EQ(partition_table_parse(&table, raw, sizeof(raw), NULL), PARTITION_TABLE_OK);
+    CHECK(table.has_md5);
+}
+
+static void test_overlap()
+{
+    build_table();
+
+    // Starts inside 'nes'
+    put(5, 0, 0x12, 0x200000, 0x20000, "ovl");
+    CHECK_EQ(partition_table_parse(&table, raw, sizeof(raw), NULL), PARTITION_TABLE_ERR_OVERLAP);
+
+    // Encloses 'gb'
+    put(5, 0, 0x12, 0x300000, 0x100000, "ovl");
+    CHECK_EQ(partition_table_parse(&table, raw, sizeof(raw), NULL), PARTITION_TABLE_ERR_OVERLAP);
+
+    // Touching is fine
+    put(5, 0, 0x12, 0x210000, 0x100000, "next");
+    CHECK_EQ(partition_table_parse(&table, raw, sizeof(raw), NULL), PARTITION_TABLE_OK);
+    CHECK_EQ(table.count, 6);
+}
+
+static void test_queries()
+{
+    build_table();
+    CHECK_EQ(partition_table_parse(&table, raw, sizeof(raw), NULL), PARTITION_TABLE_OK);
+
+    const partition_table_entry_t* factory = partition_table_find(&table, 0, 0, NULL);
+    CHECK(factory && factory->index == 2);
+
+    const partition_table_entry_t* gb = partition_table_find(&table, PARTITION_TABLE_ANY, PARTITION_TABLE_ANY, "gb");
+    CHECK(gb && gb->offset == 0x310000);
+
+    CHECK(partition_table_find(&table, 0, 0x20, NULL) == NULL);
+    CHECK(partition_table_find(&table, 1, PARTITION_TABLE_ANY, "factory") == NULL);
+
+    partition_table_gap_t gaps[8];
+    int count = partition_table_free_space(&table, 0x110000, 0x1000000, 0x10000, gaps, 8);
+    CHECK_EQ(count, 2);
+    CHECK(gaps[0].offset == 0x210000 && gaps[0].size == 0x100000);
+    CHECK(gaps[1].offset == 0x390000 && gaps[1].size == 0xc70000);
+
+    CHECK_EQ(partition_table_largest_gap(&table, 0x110000, 0x1000000, 0x10000), 0xc70000);
+
+    // The largest gap is found even past what out_gaps can hold
+    CHECK_EQ(partition_table_free_space(&table, 0x110000, 0x1000000, 0x10000, gaps, 1), 1);
+    CHECK_EQ(partition_table_largest_gap(&table, 0x110000, 0x1000000, 0x10000), 0xc70000);
+    CHECK_EQ(partition_table_largest_gap(&table, 0x110000, 0x310000, 0x10000), 0x100000);
+}
+
+
+int main()
+{
+    test_parse();
+    test_md5();
+    test_overlap();
+    test_queries();
+
+    return CHECK_DONE();
+}
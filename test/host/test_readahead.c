@@ -0,0 +1,207 @@
+#include "odroid_readahead.h"
+#include "sdcard_fixture.h"
+#include "check.h"
+
+
+#define BLOCK_SIZE (ODROID_SDCARD_BLOCK_SIZE_MIN)
+
+static int fileIndex;
+
+static odroid_sdcard_file* open_file(size_t size, bool fragmented, int* out_seed)
+{
+    char name[32];
+    char path[64];
+    *out_seed = ++fileIndex;
+    snprintf(name, sizeof(name), "r%d.bin", *out_seed);
+    fixture_file(name, size, *out_seed, fragmented, path);
+
+    odroid_sdcard_file* file = odroid_sdcard_file_open(path);
+    if (!file) abort();
+
+    return file;
+}
+
+// Streams the range and compares it. Returns the bytes seen.
+static size_t drain(odroid_readahead* stream, off_t offset, int seed, bool* out_same)
+{
+    size_t total = 0;
+    *out_same = true;
+
+    while (true)
+    {
+        size_t length;
+        const uint8_t* block = odroid_readahead_borrow(stream, &length);
+        if (!block) break;
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            if (block[i] != fixture_byte(offset + total + i, seed)) *out_same = false;
+        }
+
+        total += length;
+        odroid_readahead_return(stream, block);
+    }
+
+    return total;
+}
+
+static void check_range(size_t file_size, off_t offset, size_t length, int block_count, bool fragmented)
+{
+    int seed;
+    odroid_sdcard_file* file = open_file(file_size, fragmented, &seed);
+
+    odroid_readahead* stream = odroid_readahead_start(file, offset, length, BLOCK_SIZE, block_count);
+    CHECK(stream != NULL);
+    if (stream)
+    {
+        bool same;
+        CHECK_EQ(drain(stream, offset, seed, &same), length);
+        CHECK(same);
+        CHECK(!odroid_readahead_failed(stream));
+
+        // Stays finished
+        size_t extra;
+        CHECK(odroid_readahead_borrow(stream, &extra) == NULL);
+        CHECK_EQ(extra, 0);
+
+        odroid_readahead_stop(stream);
+    }
+
+    odroid_sdcard_file_close(file);
+
+    CHECK(fixture_tasks_finished());
+    CHECK_EQ(shim_bus_depth(), 0);
+}
+
+static void test_ranges()
+{
+    for (int fragmented = 0; fragmented < 2; ++fragmented)
+    {
+        check_range(300000, 0, 300000, 4, fragmented);
+        check_range(300000, 1000, 150000, 3, fragmented);
+        check_range(300000, 0, BLOCK_SIZE * 2, 2, fragmented);
+        check_range(300000, 777, 1, 2, fragmented);
+        check_range(100000, 0, 100000, 1, fragmented);
+        check_range(100000, 5000, 0, 2, fragmented);
+        check_range(200000, 0, 200000, ODROID_READAHEAD_BLOCK_MAX, fragmented);
+    }
+}
+
+// A range running past the end of the file is reported as a failure
+static void test_past_end()
+{
+    for (int fragmented = 0; fragmented < 2; ++fragmented)
+    {
+        int seed;
+        odroid_sdcard_file* file = open_file(100000, fragmented, &seed);
+
+        odroid_readahead* stream = odroid_readahead_start(file, 100000 - 100, 1000, BLOCK_SIZE, 2);
+        CHECK(stream != NULL);
+        if (stream)
+        {
+            bool same;
+            drain(stream, 100000 - 100, seed, &same);
+            CHECK(odroid_readahead_failed(stream));
+            odroid_readahead_stop(stream);
+        }
+
+        odroid_sdcard_file_close(file);
+        CHECK(fixture_tasks_finished());
+    }
+}
+
+static void test_read_error()
+{
+    int seed;
+    odroid_sdcard_file* file = open_file(300000, false, &seed);
+
+    shim_fail_sector_reads_after(3);
+    odroid_readahead* stream = odroid_readahead_start(file, 0, 300000, BLOCK_SIZE, 3);
+    CHECK(stream != NULL);
+    if (stream)
+    {
+        bool same;
+        CHECK(drain(stream, 0, seed, &same) < 300000);
+        CHECK(same);
+        CHECK(odroid_readahead_failed(stream));
+        odroid_readahead_stop(stream);
+    }
+    shim_fail_sector_reads_after(-1);
+
+    odroid_sdcard_file_close(file);
+    CHECK(fixture_tasks_finished());
+    CHECK_EQ(shim_bus_depth(), 0);
+}
+
+// Stopping at any point ends the task, even with blocks still borrowed
+static void test_stop_early()
+{
+    int seed;
+    odroid_sdcard_file* file = open_file(300000, false, &seed);
+
+    for (int borrowed = 0; borrowed < 4; ++borrowed)
+    {
+        odroid_readahead* stream = odroid_readahead_start(file, 0, 300000, BLOCK_SIZE, 3);
+        CHECK(stream != NULL);
+        if (!stream) continue;
+
+        for (int i = 0; i < borrowed; ++i)
+        {
+            size_t length;
+            const void* block = odroid_readahead_borrow(stream, &length);
+            CHECK(block != NULL);
+            CHECK_EQ(length, BLOCK_SIZE);
+
+            // The last one is kept
+            if (block && i + 1 < borrowed) odroid_readahead_return(stream, block);
+        }
+
+        odroid_readahead_stop(stream);
+        CHECK(fixture_tasks_finished());
+    }
+
+    odroid_sdcard_file_close(file);
+    CHECK_EQ(shim_bus_depth(), 0);
+}
+
+static void test_no_leaks()
+{
+    int seed;
+    odroid_sdcard_file* file = open_file(200000, false, &seed);
+
+    // Warm up stdio, the thread library and the shim first
+    odroid_readahead_stop(odroid_readahead_start(file, 0, 200000, BLOCK_SIZE, 3));
+    CHECK(fixture_tasks_finished());
+
+    const int fds = fixture_fd_count();
+    const size_t heap = fixture_heap_used();
+
+    for (int i = 0; i < 20; ++i)
+    {
+        odroid_readahead* stream = odroid_readahead_start(file, 0, 200000, BLOCK_SIZE, 1 + i % 4);
+        bool same;
+        if (i & 1) drain(stream, 0, seed, &same);
+        odroid_readahead_stop(stream);
+        CHECK(fixture_tasks_finished());
+    }
+
+    CHECK_EQ(fixture_fd_count(), fds);
+    CHECK_EQ(fixture_heap_used(), heap);
+
+    odroid_sdcard_file_close(file);
+}
+
+int main()
+{
+    fixture_open();
+
+    test_ranges();
+    test_past_end();
+    test_read_error();
+    test_stop_early();
+    test_no_leaks();
+
+    fixture_close();
+
+    return CHECK_DONE();
+}
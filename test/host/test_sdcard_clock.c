@@ -0,0 +1,140 @@
+#include "odroid_sdcard.h"
+#include "shim/shim.h"
+#include "check.h"
+
+#include "sdmmc_cmd.h"
+
+
+// Mount clock selection in odroid_sdcard_open; see RETRY_FASTER_INTERVAL
+#define RETRY_FASTER_INTERVAL (16)
+
+static int clocks[16];
+
+// Opens and closes the card once. Returns the number of mount attempts,
+// with their clocks in 'clocks'.
+static int mount_once()
+{
+    CHECK_EQ(odroid_sdcard_open("/sd"), ESP_OK);
+    CHECK_EQ(odroid_sdcard_close(), ESP_OK);
+    CHECK_EQ(shim_bus_depth(), 0);
+
+    return shim_mount_clocks_take(clocks, 16);
+}
+
+static void test_fast_card()
+{
+    shim_reset();
+
+    // New and known alike go straight to the fastest clock
+    for (int i = 0; i < RETRY_FASTER_INTERVAL + 2; ++i)
+    {
+        CHECK_EQ(mount_once(), 1);
+        CHECK_EQ(clocks[0], SDMMC_FREQ_HIGHSPEED);
+    }
+}
+
+static void test_slow_card()
+{
+    shim_reset();
+    shim_set_card_max_khz(26000);
+
+    // A new card steps down once, then starts at its recorded clock
+    CHECK_EQ(mount_once(), 2);
+    CHECK(clocks[0] == SDMMC_FREQ_HIGHSPEED && clocks[1] == 26000);
+
+    for (int i = 1; i < RETRY_FASTER_INTERVAL; ++i)
+    {
+        CHECK_EQ(mount_once(), 1);
+        CHECK_EQ(clocks[0], 26000);
+    }
+
+    // Periodically one step faster, then back down
+    CHECK_EQ(mount_once(), 2);
+    CHECK(clocks[0] == SDMMC_FREQ_HIGHSPEED && clocks[1] == 26000);
+
+    CHECK_EQ(mount_once(), 1);
+    CHECK_EQ(clocks[0], 26000);
+}
+
+static void test_slowest_card()
+{
+    shim_reset();
+    shim_set_card_max_khz(SDMMC_FREQ_DEFAULT);
+
+    CHECK_EQ(mount_once(), 3);
+    CHECK_EQ(clocks[2], SDMMC_FREQ_DEFAULT);
+
+    CHECK_EQ(mount_once(), 1);
+    CHECK_EQ(clocks[0], SDMMC_FREQ_DEFAULT);
+
+    // The retry only goes one step up at a time
+    for (int i = 2; i < RETRY_FASTER_INTERVAL; ++i) mount_once();
+    CHECK_EQ(mount_once(), 2);
+    CHECK(clocks[0] == 26000 && clocks[1] == SDMMC_FREQ_DEFAULT);
+}
+
+static void test_recovered_card()
+{
+    shim_reset();
+    shim_set_card_max_khz(SDMMC_FREQ_DEFAULT);
+    mount_once();
+
+    // The card copes with more now; the periodic retry moves the record up
+    shim_set_card_max_khz(0);
+    for (int i = 1; i < RETRY_FASTER_INTERVAL; ++i) mount_once();
+    CHECK_EQ(mount_once(), 1);
+    CHECK_EQ(clocks[0], 26000);
+
+    CHECK_EQ(mount_once(), 1);
+    CHECK_EQ(clocks[0], 26000);
+}
+
+static void test_card_got_slower()
+{
+    shim_reset();
+    mount_once();
+
+    shim_set_card_max_khz(26000);
+    CHECK_EQ(mount_once(), 2);
+    CHECK_EQ(mount_once(), 1);
+    CHECK_EQ(clocks[0], 26000);
+}
+
+static void test_identify_fails()
+{
+    shim_reset();
+    shim_set_card_max_khz(26000);
+    shim_set_identify_fails(true);
+
+    // Without the CID every mount starts at the fastest clock
+    CHECK_EQ(mount_once(), 2);
+    CHECK_EQ(mount_once(), 2);
+
+    // The record made after mounting is used once identification works
+    shim_set_identify_fails(false);
+    CHECK_EQ(mount_once(), 1);
+    CHECK_EQ(clocks[0], 26000);
+}
+
+static void test_no_card()
+{
+    shim_reset();
+    shim_set_card_max_khz(1);
+
+    CHECK(odroid_sdcard_open("/sd") != ESP_OK);
+    CHECK_EQ(shim_mount_clocks_take(clocks, 16), 3);
+    CHECK_EQ(shim_bus_depth(), 0);
+}
+
+int main()
+{
+    test_fast_card();
+    test_slow_card();
+    test_slowest_card();
+    test_recovered_card();
+    test_card_got_slower();
+    test_identify_fails();
+    test_no_card();
+
+    return CHECK_DONE();
+}
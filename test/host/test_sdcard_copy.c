@@ -0,0 +1,216 @@
+#include "sdcard_fixture.h"
+#include "check.h"
+
+
+#define CLUSTER_SIZE (2048)
+#define GUARD (64)
+#define FILL (0xa5)
+
+static const size_t sizes[] = {
+    1, 2, 511, 512, 513, 2047, 2048, 2049,
+    ODROID_SDCARD_BLOCK_SIZE_MIN - 1, ODROID_SDCARD_BLOCK_SIZE_MIN, ODROID_SDCARD_BLOCK_SIZE_MIN + 1,
+    ODROID_SDCARD_BLOCK_SIZE_MAX + 512, 100000, 300001 };
+#define SIZE_COUNT (sizeof(sizes) / sizeof(sizes[0]))
+
+static int fileIndex;
+
+static bool untouched(const uint8_t* buffer, size_t length)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        if (buffer[i] != FILL) return false;
+    }
+
+    return true;
+}
+
+static bool matches(const uint8_t* buffer, size_t length, int seed)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        if (buffer[i] != fixture_byte(i, seed)) return false;
+    }
+
+    return true;
+}
+
+static void check_copy(size_t size, bool fragmented, bool dma)
+{
+    char name[32];
+    char path[64];
+    const int seed = ++fileIndex;
+    snprintf(name, sizeof(name), "f%d.bin", seed);
+    fixture_file(name, size, seed, fragmented, path);
+
+    odroid_sdcard_file* file = odroid_sdcard_file_open(path);
+    CHECK(file != NULL);
+    if (file)
+    {
+        CHECK_EQ(odroid_sdcard_file_is_contiguous(file), !fragmented || size <= CLUSTER_SIZE);
+        odroid_sdcard_file_close(file);
+    }
+
+    CHECK_EQ(odroid_sdcard_get_filesize(path), size);
+
+    uint8_t* buffer = malloc(size + GUARD);
+    memset(buffer, FILL, size + GUARD);
+
+    shim_set_dma_capable(dma);
+    size_t ret = odroid_sdcard_copy_file_to_memory(path, buffer, size);
+
+    CHECK_EQ(ret, size);
+    CHECK(matches(buffer, size, seed));
+    CHECK(untouched(buffer + size, GUARD));
+
+    // One byte short of the file is refused without writing anything
+    memset(buffer, FILL, size + GUARD);
+    CHECK_EQ(odroid_sdcard_copy_file_to_memory(path, buffer, size - 1), 0);
+    CHECK(untouched(buffer, size + GUARD));
+
+    shim_set_dma_capable(true);
+    CHECK_EQ(shim_bus_depth(), 0);
+
+    free(buffer);
+}
+
+static void test_sizes()
+{
+    for (int fragmented = 0; fragmented < 2; ++fragmented)
+    {
+        for (int dma = 0; dma < 2; ++dma)
+        {
+            for (size_t i = 0; i < SIZE_COUNT; ++i)
+            {
+                check_copy(sizes[i], fragmented, dma);
+            }
+        }
+    }
+}
+
+static void test_empty_and_missing()
+{
+    char path[64];
+    uint8_t buffer[GUARD];
+
+    fixture_file("empty.bin", 0, 0, false, path);
+    memset(buffer, FILL, sizeof(buffer));
+    CHECK_EQ(odroid_sdcard_copy_file_to_memory(path, buffer, sizeof(buffer)), 0);
+    CHECK(untouched(buffer, sizeof(buffer)));
+
+    snprintf(path, sizeof(path), "%s/missing.bin", fixture_base);
+    CHECK_EQ(odroid_sdcard_get_filesize(path), 0);
+    CHECK_EQ(odroid_sdcard_copy_file_to_memory(path, buffer, sizeof(buffer)), 0);
+    CHECK(odroid_sdcard_file_open(path) == NULL);
+    CHECK(untouched(buffer, sizeof(buffer)));
+
+    CHECK_EQ(odroid_sdcard_copy_file_to_memory(path, NULL, sizeof(buffer)), 0);
+    CHECK_EQ(shim_bus_depth(), 0);
+}
+
+static void test_read_error()
+{
+    const size_t size = 100000;
+    char path[64];
+    fixture_file("error.bin", size, 3, false, path);
+
+    uint8_t* buffer = malloc(size);
+
+    for (int dma = 0; dma < 2; ++dma)
+    {
+        shim_set_dma_capable(dma);
+        shim_fail_sector_reads_after(1);
+        CHECK_EQ(odroid_sdcard_copy_file_to_memory(path, buffer, size), 0);
+        CHECK_EQ(shim_bus_depth(), 0);
+    }
+
+    shim_fail_sector_reads_after(-1);
+    shim_set_dma_capable(true);
+    free(buffer);
+}
+
+// Direct reads cover whole sectors and the staged partial ones around them
+static void test_file_seek_read()
+{
+    const size_t size = 10000;
+    char path[64];
+    fixture_file("seek.bin", size, 4, false, path);
+
+    odroid_sdcard_file* file = odroid_sdcard_file_open(path);
+    CHECK(file != NULL && odroid_sdcard_file_is_contiguous(file));
+    if (!file) return;
+
+    uint8_t buffer[3000];
+    const off_t offsets[] = { 0, 1, 511, 512, 700, 4096, 9000, 9999 };
+    for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); ++i)
+    {
+        CHECK_EQ(odroid_sdcard_file_seek(file, offsets[i], SEEK_SET), offsets[i]);
+
+        size_t expected = size - offsets[i];
+        if (expected > sizeof(buffer)) expected = sizeof(buffer);
+
+        CHECK_EQ(odroid_sdcard_file_read(file, buffer, sizeof(buffer)), expected);
+
+        bool same = true;
+        for (size_t j = 0; j < expected; ++j)
+        {
+            if (buffer[j] != fixture_byte(offsets[i] + j, 4)) same = false;
+        }
+        CHECK(same);
+    }
+
+    CHECK_EQ(odroid_sdcard_file_read(file, buffer, sizeof(buffer)), 0);
+    CHECK_EQ(odroid_sdcard_file_seek(file, -10, SEEK_END), size - 10);
+    CHECK_EQ(odroid_sdcard_file_read(file, buffer, sizeof(buffer)), 10);
+    CHECK_EQ(odroid_sdcard_file_seek(file, -1, SEEK_SET), -1);
+
+    odroid_sdcard_file_close(file);
+}
+
+// Repeated loads must not leave files open or memory behind
+static void test_no_leaks()
+{
+    const size_t size = 70000;
+    char contiguous[64];
+    char fragmented[64];
+    fixture_file("leak_c.bin", size, 5, false, contiguous);
+    fixture_file("leak_f.bin", size, 6, true, fragmented);
+
+    uint8_t* buffer = malloc(size);
+
+    // Warm up stdio and the shim before taking the baseline
+    odroid_sdcard_copy_file_to_memory(contiguous, buffer, size);
+    odroid_sdcard_copy_file_to_memory(fragmented, buffer, size);
+
+    const int fds = fixture_fd_count();
+    const size_t heap = fixture_heap_used();
+
+    for (int i = 0; i < 50; ++i)
+    {
+        shim_set_dma_capable(i & 1);
+        odroid_sdcard_copy_file_to_memory(contiguous, buffer, size);
+        odroid_sdcard_copy_file_to_memory(fragmented, buffer, size);
+        odroid_sdcard_copy_file_to_memory(fragmented, buffer, size - 1);
+    }
+
+    CHECK_EQ(fixture_fd_count(), fds);
+    CHECK_EQ(fixture_heap_used(), heap);
+    CHECK_EQ(shim_bus_depth(), 0);
+
+    shim_set_dma_capable(true);
+    free(buffer);
+}
+
+int main()
+{
+    fixture_open();
+
+    test_sizes();
+    test_empty_and_missing();
+    test_read_error();
+    test_file_seek_read();
+    test_no_leaks();
+
+    fixture_close();
+
+    return CHECK_DONE();
+}
@@ -0,0 +1,240 @@
+#include "ui_blit.h"
+#include "check.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#define WIDTH (37)
+#define HEIGHT (23)
+#define STRIDE (41) // surface is a window into a wider buffer
+#define ROWS (HEIGHT + 4)
+
+#define GUARD_VALUE (0xDEAD)
+
+static uint16_t buffer[STRIDE * ROWS];
+static uint16_t expected[STRIDE * ROWS];
+
+// Window two rows down and one pixel in, so every side has guard pixels
+static const ui_blit_surface surface = { buffer + 2 * STRIDE + 1, WIDTH, HEIGHT, STRIDE };
+
+
+static void reset()
+{
+    for (int i = 0; i < STRIDE * ROWS; ++i)
+    {
+        buffer[i] = GUARD_VALUE;
+        expected[i] = GUARD_VALUE;
+    }
+
+    for (int y = 0; y < HEIGHT; ++y)
+    {
+        for (int x = 0; x < WIDTH; ++x)
+        {
+            surface.pixels[y * STRIDE + x] = 0;
+            expected[(y + 2) * STRIDE + x + 1] = 0;
+        }
+    }
+}
+
+static void expect_pixel(int x, int y, uint16_t value)
+{
+    if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) return;
+
+    expected[(y + 2) * STRIDE + x + 1] = value;
+}
+
+static int random_coordinate(int size)
+{
+    return rand() % (size + 20) - 10;
+}
+
+static uint16_t swap(uint16_t pixel)
+{
+    return pixel << 8 | pixel >> 8;
+}
+
+
+static void test_clip()
+{
+    ui_blit_rect rect;
+
+    rect = (ui_blit_rect){ 1, 2, 3, 4 };
+    CHECK(ui_blit_clip(&surface, &rect));
+    CHECK(rect.left == 1 && rect.top == 2 && rect.right == 3 && rect.bottom == 4);
+
+    // Corners given in either order
+    rect = (ui_blit_rect){ 3, 4, 1, 2 };
+    CHECK(ui_blit_clip(&surface, &rect));
+    CHECK(rect.left == 1 && rect.top == 2 && rect.right == 3 && rect.bottom == 4);
+
+    rect = (ui_blit_rect){ -5, -5, WIDTH + 5, HEIGHT + 5 };
+    CHECK(ui_blit_clip(&surface, &rect));
+    CHECK(rect.left == 0 && rect.top == 0 && rect.right == WIDTH - 1 && rect.bottom == HEIGHT - 1);
+
+    // Single pixel on each corner
+    rect = (ui_blit_rect){ WIDTH - 1, HEIGHT - 1, WIDTH - 1, HEIGHT - 1 };
+    CHECK(ui_blit_clip(&surface, &rect));
+
+    rect = (ui_blit_rect){ -3, -3, -1, 5 };
+    CHECK(!ui_blit_clip(&surface, &rect));
+    rect = (ui_blit_rect){ WIDTH, 0, WIDTH + 3, 5 };
+    CHECK(!ui_blit_clip(&surface, &rect));
+    rect = (ui_blit_rect){ 0, HEIGHT, 5, HEIGHT };
+    CHECK(!ui_blit_clip(&surface, &rect));
+    rect = (ui_blit_rect){ 0, -2, 5, -1 };
+    CHECK(!ui_blit_clip(&surface, &rect));
+}
+
+static void test_rows()
+{
+    // Every alignment and length against a per-pixel reference
+    uint16_t dst[40];
+    uint16_t src[40];
+    for (int i = 0; i < 40; ++i) src[i] = 0x0100 * i + 0x80 + i;
+
+    for (int offset = 0; offset < 2; ++offset)
+    {
+        for (int src_offset = 0; src_offset < 2; ++src_offset)
+        {
+            for (int count = 0; count < 32; ++count)
+            {
+                for (int i = 0; i < 40; ++i) dst[i] = GUARD_VALUE;
+                ui_blit_swap_row(dst + offset, src + src_offset, count);
+
+                bool ok = true;
+                for (int i = 0; i < 40; ++i)
+                {
+                    int n = i - offset;
+                    uint16_t want = (n >= 0 && n < count) ? swap(src[src_offset + n]) : GUARD_VALUE;
+                    if (dst[i] != want) ok = false;
+                }
+                CHECK(ok);
+            }
+        }
+
+        for (int count = 0; count < 32; ++count)
+        {
+            for (int i = 0; i < 40; ++i) dst[i] = GUARD_VALUE;
+            ui_blit_fill_row(dst + offset, count, 0x1234);
+
+            bool ok = true;
+            for (int i = 0; i < 40; ++i)
+            {
+                int n = i - offset;
+                if (dst[i] != ((n >= 0 && n < count) ? 0x1234 : GUARD_VALUE)) ok = false;
+            }
+            CHECK(ok);
+        }
+    }
+}
+
+static void test_fill()
+{
+    for (int i = 0; i < 2000; ++i)
+    {
+        reset();
+
+        short left = random_coordinate(WIDTH);
+        short top = random_coordinate(HEIGHT);
+        short right = random_coordinate(WIDTH);
+        short bottom = random_coordinate(HEIGHT);
+        uint16_t color = rand();
+
+        bool any = false;
+        for (int y = top < bottom ? top : bottom; y <= (top < bottom ? bottom : top); ++y)
+        {
+            for (int x = left < right ? left : right; x <= (left < right ? right : left); ++x)
+            {
+                if (x >= 0 && y >= 0 && x < WIDTH && y < HEIGHT) any = true;
+                expect_pixel(x, y, color);
+            }
+        }
+
+        ui_blit_rect drawn = { -100, -100, -100, -100 };
+        bool result = ui_blit_fill(&surface, left, top, right, bottom, color, &drawn);
+
+        CHECK_EQ(result, any);
+        CHECK(memcmp(buffer, expected, sizeof(buffer)) == 0);
+
+        if (result)
+        {
+            ui_blit_rect want = { left, top, right, bottom };
+            ui_blit_clip(&surface, &want);
+            CHECK(memcmp(&drawn, &want, sizeof(want)) == 0);
+        }
+    }
+}
+
+static void test_copy()
+{
+    uint16_t src[24 * 20];
+    for (int i = 0; i < 24 * 20; ++i) src[i] = rand();
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        reset();
+
+        short width = 1 + rand() % 20;
+        short height = 1 + rand() % 20;
+        short src_stride = width + rand() % (24 - width + 1);
+        short x = random_coordinate(WIDTH);
+        short y = random_coordinate(HEIGHT);
+        int flags = (rand() & 1) ? UI_BLIT_SWAP : 0;
+
+        bool any = false;
+        for (int row = 0; row < height; ++row)
+        {
+            for (int col = 0; col < width; ++col)
+            {
+                if (x + col >= 0 && y + row >= 0 && x + col < WIDTH && y + row < HEIGHT) any = true;
+
+                uint16_t pixel = src[row * src_stride + col];
+                expect_pixel(x + col, y + row, (flags & UI_BLIT_SWAP) ? swap(pixel) : pixel);
+            }
+        }
+
+        bool result = ui_blit_copy(&surface, x, y, width, height, src, src_stride, flags, NULL);
+
+        CHECK_EQ(result, any);
+        CHECK(memcmp(buffer, expected, sizeof(buffer)) == 0);
+    }
+
+    // Invalid sizes draw nothing
+    reset();
+    CHECK(!ui_blit_copy(&surface, 0, 0, 0, 5, src, 5, 0, NULL));
+    CHECK(!ui_blit_copy(&surface, 0, 0, 5, 0, src, 5, 0, NULL));
+    CHECK(!ui_blit_copy(&surface, 0, 0, 5, 5, src, 4, 0, NULL));
+    CHECK(memcmp(buffer, expected, sizeof(buffer)) == 0);
+}
+
+static void test_frame()
+{
+    // Partly visible: only the top and left edges are inside
+    reset();
+    ui_blit_rect drawn;
+    CHECK(ui_blit_frame(&surface, 2, 3, WIDTH + 4, HEIGHT + 4, 0x5555, &drawn));
+    CHECK(drawn.left == 2 && drawn.top == 3 && drawn.right == WIDTH - 1 && drawn.bottom == HEIGHT - 1);
+    for (int x = 2; x < WIDTH; ++x) expect_pixel(x, 3, 0x5555);
+    for (int y = 3; y < HEIGHT; ++y) expect_pixel(2, y, 0x5555);
+    CHECK(memcmp(buffer, expected, sizeof(buffer)) == 0);
+
+    // Encloses the surface: no edge is visible
+    reset();
+    CHECK(!ui_blit_frame(&surface, -1, -1, WIDTH, HEIGHT, 0x5555, &drawn));
+    CHECK(memcmp(buffer, expected, sizeof(buffer)) == 0);
+}
+
+
+int main()
+{
+    srand(1);
+
+    test_clip();
+    test_rows();
+    test_fill();
+    test_copy();
+    test_frame();
+
+    return CHECK_DONE();
+}
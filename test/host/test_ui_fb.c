@@ -0,0 +1,183 @@
+#include "ui_fb.h"
+#include "check.h"
+
+#include <stdbool.h>
+
+
+#define WIDTH (40)
+#define HEIGHT (30)
+#define GUARD (64)
+
+#define BACKGROUND (0x0000)
+#define GUARD_VALUE (0xDEAD)
+
+// The framebuffer sits between guard areas that must never be written
+static uint16_t memory[GUARD + WIDTH * HEIGHT + GUARD];
+static uint16_t* const fb = memory + GUARD;
+static UG_GUI gui;
+
+
+static bool guards_intact()
+{
+    for (int i = 0; i < GUARD; ++i)
+    {
+        if (memory[i] != GUARD_VALUE) return false;
+        if (memory[GUARD + WIDTH * HEIGHT + i] != GUARD_VALUE) return false;
+    }
+
+    return true;
+}
+
+// Every pixel that differs from the background must be inside the dirty
+// rectangle
+static bool changes_inside_dirty()
+{
+    short left, top, width, height;
+    bool dirty = ui_fb_dirty_get(&left, &top, &width, &height);
+
+    for (int y = 0; y < HEIGHT; ++y)
+    {
+        for (int x = 0; x < WIDTH; ++x)
+        {
+            if (fb[y * WIDTH + x] == BACKGROUND) continue;
+            if (!dirty) return false;
+            if (x < left || x >= left + width || y < top || y >= top + height) return false;
+        }
+    }
+
+    return true;
+}
+
+static void reset()
+{
+    for (int i = 0; i < GUARD + WIDTH * HEIGHT + GUARD; ++i)
+    {
+        memory[i] = GUARD_VALUE;
+    }
+    for (int i = 0; i < WIDTH * HEIGHT; ++i)
+    {
+        fb[i] = BACKGROUND;
+    }
+
+    ui_fb_dirty_clear();
+}
+
+#define CHECK_DIRTY(l, t, w, h) \
+    do \
+    { \
+        short dirty_left, dirty_top, dirty_width, dirty_height; \
+        CHECK(ui_fb_dirty_get(&dirty_left, &dirty_top, &dirty_width, &dirty_height)); \
+        CHECK_EQ(dirty_left, l); \
+        CHECK_EQ(dirty_top, t); \
+        CHECK_EQ(dirty_width, w); \
+        CHECK_EQ(dirty_height, h); \
+    } while (0)
+
+#define CHECK_CLEAN() \
+    do \
+    { \
+        short dirty_left, dirty_top, dirty_width, dirty_height; \
+        CHECK(!ui_fb_dirty_get(&dirty_left, &dirty_top, &dirty_width, &dirty_height)); \
+    } while (0)
+
+
+static void test_dirty()
+{
+    // Everything is dirty after init
+    UG_Init(&gui, ui_fb_pset, WIDTH, HEIGHT);
+    ui_fb_init(fb, WIDTH, HEIGHT);
+    CHECK_DIRTY(0, 0, WIDTH, HEIGHT);
+
+    reset();
+    CHECK_CLEAN();
+
+    ui_fb_pset(5, 6, 0xFFFF);
+    CHECK_DIRTY(5, 6, 1, 1);
+    CHECK_EQ(fb[6 * WIDTH + 5], 0xFFFF);
+
+    // The dirty rectangle is the union of everything drawn
+    ui_fb_mark_dirty(10, 2, 12, 3);
+    CHECK_DIRTY(5, 2, 8, 5);
+
+    ui_fb_dirty_clear();
+    CHECK_CLEAN();
+}
+
+static void test_clip()
+{
+    reset();
+
+    // Off-surface pixels are dropped without dirtying
+    ui_fb_pset(-1, 0, 0xFFFF);
+    ui_fb_pset(0, HEIGHT, 0xFFFF);
+    ui_fb_pset(WIDTH, 0, 0xFFFF);
+    CHECK_CLEAN();
+
+    // Fully outside
+    UG_FillFrame(WIDTH + 1, 0, WIDTH + 10, 10, 0x1234);
+    UG_FillFrame(-20, -20, -1, -1, 0x1234);
+    CHECK_CLEAN();
+    CHECK(guards_intact());
+
+    // Overhanging the top left corner
+    reset();
+    UG_FillFrame(-5, -5, 3, 4, 0x1111);
+    CHECK_DIRTY(0, 0, 4, 5);
+    CHECK_EQ(fb[0], 0x1111);
+    CHECK_EQ(fb[4 * WIDTH + 3], 0x1111);
+    CHECK_EQ(fb[4 * WIDTH + 4], BACKGROUND);
+    CHECK(changes_inside_dirty());
+
+    // Axis aligned line overhanging the bottom right corner
+    reset();
+    UG_DrawLine(WIDTH - 2, HEIGHT - 1, WIDTH + 20, HEIGHT - 1, 0x2222);
+    CHECK_DIRTY(WIDTH - 2, HEIGHT - 1, 2, 1);
+    CHECK(guards_intact());
+    CHECK(changes_inside_dirty());
+
+    reset();
+    ui_fb_draw_frame(-3, 10, WIDTH + 3, 12, 0x3333);
+    CHECK_DIRTY(0, 10, WIDTH, 3);
+    CHECK(changes_inside_dirty());
+
+    uint16_t image[8 * 8];
+    for (int i = 0; i < 8 * 8; ++i) image[i] = 0x4444;
+    reset();
+    ui_fb_draw_image(WIDTH - 3, -2, 8, 8, image);
+    CHECK_DIRTY(WIDTH - 3, 0, 3, 6);
+    CHECK(guards_intact());
+    CHECK(changes_inside_dirty());
+}
+
+static void test_text_clip()
+{
+    reset();
+
+    // Glyphs go through the FILL_AREA driver, which must clip the pixel
+    // stream and the dirty rectangle alike
+    UG_FontSelect(&FONT_8X12);
+    UG_PutChar('W', -3, -4, 0xFFFF, 0x5555);
+    CHECK_DIRTY(0, 0, 5, 8);
+    CHECK(changes_inside_dirty());
+
+    reset();
+    UG_PutChar('W', WIDTH - 4, HEIGHT - 6, 0xFFFF, 0x5555);
+    CHECK_DIRTY(WIDTH - 4, HEIGHT - 6, 4, 6);
+
+    UG_PutChar('W', WIDTH + 1, 0, 0xFFFF, 0x5555);
+    UG_PutChar('W', 0, -20, 0xFFFF, 0x5555);
+    CHECK_DIRTY(WIDTH - 4, HEIGHT - 6, 4, 6);
+
+    CHECK(guards_intact());
+    CHECK(changes_inside_dirty());
+}
+
+
+int main()
+{
+    test_dirty();
+    test_clip();
+    test_text_clip();
+
+    return CHECK_DONE();
+}
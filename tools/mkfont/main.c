@@ -0,0 +1,433 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#include "ugui.h"
+
+// Emits a replacement for the uGUI font tables that only contains the fonts
+// referenced by the given sources, each trimmed to a glyph range. The result
+// is compiled in place of the full tables when UGUI_FONT_SUBSET is defined.
+// The default range is printable ASCII, widened to the highest character
+// code that appears in the sources unless -r gives the range explicitly.
+// With -s the glyphs are stored as per-row foreground runs (FONT_TYPE_SPAN)
+// so uGUI draws them with a few span fills instead of one pset per pixel.
+
+#define DEFAULT_FIRST_CHAR (0x20)
+#define DEFAULT_LAST_CHAR (0x7e)
+
+
+typedef struct
+{
+    const char* name;
+    const char* table;
+    const UG_FONT* font;
+    int used;
+    int ranged; // range given with -r
+    int first;
+    int last;
+} font_entry_t;
+
+#define FONT_ENTRY(font_name, table_name) \
+    { .name = #font_name, .table = table_name, .font = &font_name }
+
+static font_entry_t Fonts[] = {
+#ifdef USE_FONT_4X6
+    FONT_ENTRY(FONT_4X6, "font_4x6"),
+#endif
+#ifdef USE_FONT_5X8
+    FONT_ENTRY(FONT_5X8, "font_5x8"),
+#endif
+#ifdef USE_FONT_5X12
+    FONT_ENTRY(FONT_5X12, "font_5x12"),
+#endif
+#ifdef USE_FONT_6X8
+    FONT_ENTRY(FONT_6X8, "font_6x8"),
+#endif
+#ifdef USE_FONT_6X10
+    FONT_ENTRY(FONT_6X10, "font_6x10"),
+#endif
+#ifdef USE_FONT_7X12
+    FONT_ENTRY(FONT_7X12, "font_7x12"),
+#endif
+#ifdef USE_FONT_8X8
+    FONT_ENTRY(FONT_8X8, "font_8x8"),
+#endif
+#if defined(USE_FONT_8X12) || defined(USE_FONT_8X12_CYRILLIC)
+    FONT_ENTRY(FONT_8X12, "font_8x12"),
+#endif
+#ifdef USE_FONT_8X14
+    FONT_ENTRY(FONT_8X14, "font_8x14"),
+#endif
+#ifdef USE_FONT_10X16
+    FONT_ENTRY(FONT_10X16, "font_10x16"),
+#endif
+#ifdef USE_FONT_12X16
+    FONT_ENTRY(FONT_12X16, "font_12x16"),
+#endif
+#ifdef USE_FONT_12X20
+    FONT_ENTRY(FONT_12X20, "font_12x20"),
+#endif
+#ifdef USE_FONT_16X26
+    FONT_ENTRY(FONT_16X26, "font_16x26"),
+#endif
+#ifdef USE_FONT_22X36
+    FONT_ENTRY(FONT_22X36, "font_22x36"),
+#endif
+#ifdef USE_FONT_24X40
+    FONT_ENTRY(FONT_24X40, "font_24x40"),
+#endif
+#ifdef USE_FONT_32X53
+    FONT_ENTRY(FONT_32X53, "font_32x53"),
+#endif
+};
+
+#define FONT_COUNT ((int)(sizeof(Fonts) / sizeof(Fonts[0])))
+
+// Highest character code seen in the sources above the default range
+static int source_last_char = DEFAULT_LAST_CHAR;
+
+
+static font_entry_t* font_find(const char* name, size_t length)
+{
+    for (int i = 0; i < FONT_COUNT; ++i)
+    {
+        if (strlen(Fonts[i].name) == length &&
+            memcmp(Fonts[i].name, name, length) == 0)
+        {
+            return &Fonts[i];
+        }
+    }
+
+    return NULL;
+}
+
+static int is_ident(int c)
+{
+    return isalnum(c) || c == '_';
+}
+
+static int glyph_size(const UG_FONT* font)
+{
+    return font->char_height * ((font->char_width + 7) / 8);
+}
+
+static int font_size(const font_entry_t* entry)
+{
+    return (entry->font->end_char - entry->font->start_char + 1) * glyph_size(entry->font);
+}
+
+static int subset_size(const font_entry_t* entry)
+{
+    return (entry->last - entry->first + 1) * glyph_size(entry->font);
+}
+
+static void scan_file(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        printf("mkfont: can not open '%s'.\n", path);
+        abort();
+    }
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* text = malloc(length + 1);
+    if (!text) abort();
+
+    if (fread(text, 1, length, file) != (size_t)length)
+    {
+        printf("mkfont: read failed '%s'.\n", path);
+        abort();
+    }
+    text[length] = 0;
+    fclose(file);
+
+    // Non-ASCII characters in string literals (or, harmlessly, comments)
+    // widen the subset so they are not dropped when drawn.
+    for (long i = 0; i < length; ++i)
+    {
+        int c = (unsigned char)text[i];
+        if (c > source_last_char) source_last_char = c;
+    }
+
+    // Tokens of the form FONT_<w>X<h>; FONT_TYPE_* and friends never match
+    // a table entry so they fall through font_find.
+    const char* p = text;
+    while ((p = strstr(p, "FONT_")) != NULL)
+    {
+        const char* end = p + 5;
+        while (is_ident(*end)) ++end;
+
+        if (p == text || !is_ident(p[-1]))
+        {
+            font_entry_t* entry = font_find(p, end - p);
+            if (entry && !entry->used)
+            {
+                printf("mkfont: %s referenced by %s\n", entry->name, path);
+                entry->used = 1;
+            }
+        }
+
+        p = end;
+    }
+
+    free(text);
+}
+
+static void parse_range(const char* arg)
+{
+    const char* eq = strchr(arg, '=');
+    if (!eq) goto fail;
+
+    font_entry_t* entry = font_find(arg, eq - arg);
+    if (!entry)
+    {
+        printf("mkfont: unknown font in range '%s'.\n", arg);
+        abort();
+    }
+
+    char* end;
+    long first = strtol(eq + 1, &end, 0);
+    if (*end != '-') goto fail;
+
+    long last = strtol(end + 1, &end, 0);
+    if (*end) goto fail;
+
+    if (first < entry->font->start_char || last > entry->font->end_char || first > last)
+        goto fail;
+
+    entry->first = first;
+    entry->last = last;
+    entry->ranged = 1;
+    return;
+
+fail:
+    printf("mkfont: invalid range '%s', expected FONT_WxH=first-last.\n", arg);
+    abort();
+}
+
+static int write_font_bitmap(FILE* file, const font_entry_t* entry)
+{
+    const UG_FONT* font = entry->font;
+    const int size = glyph_size(font);
+
+    fprintf(file, "static __UG_FONT_DATA unsigned char %s_subset[%d][%d]={\n",
+        entry->table, entry->last - entry->first + 1, size);
+
+    for (int c = entry->first; c <= entry->last; ++c)
+    {
+        const unsigned char* glyph = font->p + (c - font->start_char) * size;
+
+        fprintf(file, "{");
+        for (int i = 0; i < size; ++i)
+        {
+            fprintf(file, "0x%02X%s", glyph[i], (i < size - 1) ? "," : "");
+        }
+        fprintf(file, "}%s   // 0x%02X\n", (c < entry->last) ? "," : " ", c);
+    }
+
+    fprintf(file, "};\n\n");
+
+    fprintf(file, "const UG_FONT %s = {(unsigned char*)%s_subset,FONT_TYPE_1BPP,%d,%d,0x%02X,0x%02X,NULL};\n\n",
+        entry->name, entry->table, font->char_width, font->char_height,
+        entry->first, entry->last);
+
+    return subset_size(entry);
+}
+
+// Appends the foreground runs of one glyph row as count, (x, length)...
+static int row_spans(const unsigned char* row, int width, unsigned char* out)
+{
+    int count = 0;
+    int x = 0;
+
+    while (x < width)
+    {
+        if (!(row[x >> 3] & (1 << (x & 7))))
+        {
+            ++x;
+            continue;
+        }
+
+        int start = x;
+        while (x < width && (row[x >> 3] & (1 << (x & 7)))) ++x;
+
+        out[1 + count * 2] = start;
+        out[2 + count * 2] = x - start;
+        ++count;
+    }
+
+    out[0] = count;
+    return 1 + count * 2;
+}
+
+static int write_font_spans(FILE* file, const font_entry_t* entry)
+{
+    const UG_FONT* font = entry->font;
+    const int size = glyph_size(font);
+    const int bn = (font->char_width + 7) / 8;
+    const int glyphs = entry->last - entry->first + 1;
+
+    unsigned char* runs = malloc(glyphs * font->char_height * (1 + font->char_width));
+    int* offsets = malloc(glyphs * sizeof(int));
+    if (!runs || !offsets) abort();
+
+    int length = 0;
+    for (int c = entry->first; c <= entry->last; ++c)
+    {
+        const unsigned char* glyph = font->p + (c - font->start_char) * size;
+
+        offsets[c - entry->first] = length;
+        for (int j = 0; j < font->char_height; ++j)
+        {
+            length += row_spans(glyph + j * bn, font->char_width, runs + length);
+        }
+    }
+
+    if (length > 0xffff)
+    {
+        printf("mkfont: %s span data too large (%d bytes).\n", entry->name, length);
+        abort();
+    }
+
+    fprintf(file, "static const UG_U16 %s_span_offsets[%d]={\n", entry->table, glyphs);
+    for (int c = entry->first; c <= entry->last; ++c)
+    {
+        fprintf(file, "%d%s   // 0x%02X\n", offsets[c - entry->first], (c < entry->last) ? "," : " ", c);
+    }
+    fprintf(file, "};\n\n");
+
+    fprintf(file, "static const UG_U8 %s_span_runs[%d]={\n", entry->table, length);
+    for (int c = entry->first; c <= entry->last; ++c)
+    {
+        int start = offsets[c - entry->first];
+        int end = (c < entry->last) ? offsets[c - entry->first + 1] : length;
+
+        for (int i = start; i < end; ++i)
+        {
+            fprintf(file, "%d%s", runs[i], (i < length - 1) ? "," : "");
+        }
+        fprintf(file, "   // 0x%02X\n", c);
+    }
+    fprintf(file, "};\n\n");
+
+    fprintf(file, "static const UG_SPAN_DATA %s_spans = {%s_span_offsets,%s_span_runs};\n\n",
+        entry->table, entry->table, entry->table);
+
+    fprintf(file, "const UG_FONT %s = {(unsigned char*)&%s_spans,FONT_TYPE_SPAN,%d,%d,0x%02X,0x%02X,NULL};\n\n",
+        entry->name, entry->table, font->char_width, font->char_height,
+        entry->first, entry->last);
+
+    free(offsets);
+    free(runs);
+
+    return glyphs * sizeof(uint16_t) + length + sizeof(UG_SPAN_DATA);
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char* output = NULL;
+    int source_count = 0;
+    int spans = 0;
+
+    for (int i = 0; i < FONT_COUNT; ++i)
+    {
+        Fonts[i].first = DEFAULT_FIRST_CHAR;
+        Fonts[i].last = DEFAULT_LAST_CHAR;
+    }
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            parse_range(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-s") == 0)
+        {
+            spans = 1;
+        }
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+        {
+            font_entry_t* entry = font_find(argv[i + 1], strlen(argv[i + 1]));
+            if (!entry)
+            {
+                printf("mkfont: unknown font '%s'.\n", argv[i + 1]);
+                abort();
+            }
+            entry->used = 1;
+            ++i;
+        }
+        else
+        {
+            scan_file(argv[i]);
+            ++source_count;
+        }
+    }
+
+    if (!output || source_count == 0)
+    {
+        printf("usage: %s -o output.c [-s] [-r FONT_WxH=first-last] [-f FONT_WxH] source.c [...]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* file = fopen(output, "wb");
+    if (!file)
+    {
+        printf("mkfont: can not create '%s'.\n", output);
+        abort();
+    }
+
+    fprintf(file, "// Generated by tools/mkfont. Do not edit.\n\n");
+    fprintf(file, "#include \"ugui.h\"\n\n");
+
+    int before = 0;
+    int after = 0;
+
+    for (int i = 0; i < FONT_COUNT; ++i)
+    {
+        font_entry_t* entry = &Fonts[i];
+
+        before += font_size(entry);
+        if (!entry->used) continue;
+
+        if (!entry->ranged && source_last_char > entry->last)
+        {
+            entry->last = source_last_char;
+            if (entry->last > entry->font->end_char) entry->last = entry->font->end_char;
+        }
+
+        if (entry->font->font_type != FONT_TYPE_1BPP || entry->font->widths)
+        {
+            printf("mkfont: %s is not a fixed width 1bpp font.\n", entry->name);
+            abort();
+        }
+
+        int size = spans ? write_font_spans(file, entry) : write_font_bitmap(file, entry);
+        after += size;
+
+        printf("mkfont: %s 0x%02X-0x%02X%s: %d bytes (was %d)\n",
+            entry->name, entry->first, entry->last, spans ? " spans" : "",
+            size, font_size(entry));
+    }
+
+    if (fclose(file) != 0)
+    {
+        printf("mkfont: write failed '%s'.\n", output);
+        abort();
+    }
+
+    printf("mkfont: font data %d bytes (was %d), saved %d bytes.\n",
+        after, before, before - after);
+
+    return 0;
+}
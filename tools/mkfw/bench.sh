@@ -0,0 +1,24 @@
+#!/bin/bash
+# Packages a 64 MB synthetic bundle (four 16 MB partitions) with 1 to N
+# jobs. Run after make; the inputs are created in a temporary directory.
+set -e
+
+MKFW="$(pwd)/mkfw"
+JOBS_MAX=${1:-$(nproc)}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+cd "$WORK"
+head -c 8256 /dev/zero > tile.raw
+for i in 0 1 2 3; do
+    head -c $((16 * 1024 * 1024)) /dev/urandom > part$i.bin
+done
+
+PARTS="0 16 16777216 app0 part0.bin 0 17 16777216 app1 part1.bin 1 130 16777216 data0 part2.bin 1 131 16777216 data1 part3.bin"
+
+# Warm the page cache so the runs compare CRC and copy work, not the disk
+cat part*.bin > /dev/null
+
+for ((j = 1; j <= JOBS_MAX; j *= 2)); do
+    "$MKFW" -j $j -o bench.fw "bench" tile.raw $PARTS | tail -n 1
+done
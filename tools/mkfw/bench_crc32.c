@@ -0,0 +1,66 @@
+// Throughput of each CRC32 implementation this machine can run, from
+// short headers to partition sized buffers. Run with: make bench
+#include "crc32_fast.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run(const char* name, crc32_impl_t function, const uint8_t* data, size_t size)
+{
+    const size_t lengths[] = { 64, 1024, 64 * 1024, 16 * 1024 * 1024 };
+
+    printf("%-12s", name);
+
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i)
+    {
+        const size_t length = lengths[i] < size ? lengths[i] : size;
+        const size_t rounds = (256 * 1024 * 1024) / length;
+
+        // Chained so the calls can not be folded away
+        uint32_t crc = 0;
+        double start = now();
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            crc = function(crc, data, length);
+        }
+        double elapsed = now() - start;
+
+        printf("  %8zu B %8.1f MB/s", length, (double)length * rounds / elapsed / (1024 * 1024));
+        if (crc == 0x12345678) printf("*");
+    }
+
+    printf("\n");
+}
+
+int main()
+{
+    const size_t size = 16 * 1024 * 1024;
+    uint8_t* data = malloc(size);
+    if (!data) return 1;
+
+    for (size_t i = 0; i < size; ++i) data[i] = (uint8_t)(i * 131 + (i >> 12));
+
+    printf("selected: %s\n", crc32_fast_name());
+
+    run("slice-by-16", crc32_slice16, data, size);
+
+#ifdef CRC32_FAST_X86
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1")) run("pclmulqdq", crc32_pclmul, data, size);
+#endif
+
+#ifdef CRC32_FAST_ARM
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32) run("armv8-crc32", crc32_armv8, data, size);
+#endif
+
+    free(data);
+    return 0;
+}
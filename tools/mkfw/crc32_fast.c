@@ -0,0 +1,320 @@
+#include "crc32_fast.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRC32_FAST_X86
+#endif
+
+#if defined(__aarch64__) && defined(__linux__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#define CRC32_FAST_ARM
+#endif
+
+
+#define POLY (0xedb88320u)
+
+typedef uint32_t (*crc32_impl_t)(uint32_t crc, const uint8_t* buf, size_t len);
+
+static uint32_t table[16][256];
+static uint32_t x2n_table[32];
+
+static crc32_impl_t impl;
+static const char* impl_name;
+
+
+static inline uint32_t load_le32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Works on the inverted register, like the hardware paths
+static uint32_t crc32_slice16(uint32_t crc, const uint8_t* buf, size_t len)
+{
+    while (len >= 16)
+    {
+        uint32_t a = load_le32(buf) ^ crc;
+        uint32_t b = load_le32(buf + 4);
+        uint32_t c = load_le32(buf + 8);
+        uint32_t d = load_le32(buf + 12);
+
+        crc = table[15][a & 0xff] ^ table[14][(a >> 8) & 0xff] ^
+              table[13][(a >> 16) & 0xff] ^ table[12][a >> 24] ^
+              table[11][b & 0xff] ^ table[10][(b >> 8) & 0xff] ^
+              table[9][(b >> 16) & 0xff] ^ table[8][b >> 24] ^
+              table[7][c & 0xff] ^ table[6][(c >> 8) & 0xff] ^
+              table[5][(c >> 16) & 0xff] ^ table[4][c >> 24] ^
+              table[3][d & 0xff] ^ table[2][(d >> 8) & 0xff] ^
+              table[1][(d >> 16) & 0xff] ^ table[0][d >> 24];
+
+        buf += 16;
+        len -= 16;
+    }
+
+    while (len--)
+    {
+        crc = table[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+
+#ifdef CRC32_FAST_X86
+
+#define PCLMUL_MIN_LENGTH (64)
+
+// Folds four 128 bit lanes across the buffer, then down to one lane and a
+// Barrett reduction to 32 bits. Constants are powers of x modulo the
+// reflected polynomial ("Fast CRC Computation for Generic Polynomials
+// Using PCLMULQDQ", Intel, 2009).
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc32_pclmul_fold(uint32_t crc, const uint8_t* buf, size_t len)
+{
+    static const uint64_t __attribute__((aligned(16))) k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+    static const uint64_t __attribute__((aligned(16))) k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+    static const uint64_t __attribute__((aligned(16))) k5k0[] = { 0x0163cd6124, 0x0000000000 };
+    static const uint64_t __attribute__((aligned(16))) poly[] = { 0x01db710641, 0x01f7011641 };
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    x1 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+    x2 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+    x3 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+    x4 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+    x0 = _mm_load_si128((const __m128i*)k1k2);
+
+    buf += 64;
+    len -= 64;
+
+    while (len >= 64)
+    {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        y5 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+        y6 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+        y7 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+        y8 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+        buf += 64;
+        len -= 64;
+    }
+
+    // Fold the four lanes into one
+    x0 = _mm_load_si128((const __m128i*)k3k4);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    // Remaining whole 16 byte blocks
+    while (len >= 16)
+    {
+        x2 = _mm_loadu_si128((const __m128i*)buf);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        buf += 16;
+        len -= 16;
+    }
+
+    // 128 to 64 bits
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_loadl_epi64((const __m128i*)k5k0);
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x0 = _mm_load_si128((const __m128i*)poly);
+
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    crc = (uint32_t)_mm_extract_epi32(x1, 1);
+
+    return crc32_slice16(crc, buf, len);
+}
+
+static uint32_t crc32_pclmul(uint32_t crc, const uint8_t* buf, size_t len)
+{
+    if (len < PCLMUL_MIN_LENGTH) return crc32_slice16(crc, buf, len);
+
+    return crc32_pclmul_fold(crc, buf, len);
+}
+
+#endif
+
+
+#ifdef CRC32_FAST_ARM
+
+__attribute__((target("+crc")))
+static uint32_t crc32_armv8(uint32_t crc, const uint8_t* buf, size_t len)
+{
+    while (len > 0 && ((uintptr_t)buf & 7))
+    {
+        crc = __crc32b(crc, *buf++);
+        --len;
+    }
+
+    while (len >= 8)
+    {
+        uint64_t value;
+        memcpy(&value, buf, sizeof(value));
+        crc = __crc32d(crc, value);
+
+        buf += 8;
+        len -= 8;
+    }
+
+    while (len--)
+    {
+        crc = __crc32b(crc, *buf++);
+    }
+
+    return crc;
+}
+
+#endif
+
+
+// a * b modulo the polynomial, bit reflected
+static uint32_t multmodp(uint32_t a, uint32_t b)
+{
+    uint32_t m = (uint32_t)1 << 31;
+    uint32_t p = 0;
+
+    while (1)
+    {
+        if (a & m)
+        {
+            p ^= b;
+            if ((a & (m - 1)) == 0) break;
+        }
+
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ POLY : b >> 1;
+    }
+
+    return p;
+}
+
+// x^(n * 2^k) modulo the polynomial
+static uint32_t x2nmodp(uint64_t n, unsigned k)
+{
+    uint32_t p = (uint32_t)1 << 31; // x^0
+
+    while (n)
+    {
+        if (n & 1) p = multmodp(x2n_table[k & 31], p);
+
+        n >>= 1;
+        ++k;
+    }
+
+    return p;
+}
+
+__attribute__((constructor))
+static void crc32_fast_init()
+{
+    for (uint32_t n = 0; n < 256; ++n)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k)
+        {
+            c = (c & 1) ? (c >> 1) ^ POLY : c >> 1;
+        }
+
+        table[0][n] = c;
+    }
+
+    for (uint32_t n = 0; n < 256; ++n)
+    {
+        for (int t = 1; t < 16; ++t)
+        {
+            table[t][n] = (table[t - 1][n] >> 8) ^ table[0][table[t - 1][n] & 0xff];
+        }
+    }
+
+    uint32_t p = (uint32_t)1 << 30; // x^1
+    x2n_table[0] = p;
+    for (int n = 1; n < 32; ++n)
+    {
+        x2n_table[n] = p = multmodp(p, p);
+    }
+
+    impl = crc32_slice16;
+    impl_name = "slice-by-16";
+
+#ifdef CRC32_FAST_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1"))
+    {
+        impl = crc32_pclmul;
+        impl_name = "pclmulqdq";
+    }
+#endif
+
+#ifdef CRC32_FAST_ARM
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+    {
+        impl = crc32_armv8;
+        impl_name = "armv8-crc32";
+    }
+#endif
+}
+
+uint32_t crc32_fast(uint32_t crc, const void* buf, size_t len)
+{
+    if (!buf) return 0;
+
+    return ~impl(~crc, (const uint8_t*)buf, len);
+}
+
+uint32_t crc32_fast_combine(uint32_t crc1, uint32_t crc2, uint64_t len2)
+{
+    return multmodp(x2nmodp(len2, 3), crc1) ^ crc2;
+}
+
+const char* crc32_fast_name()
+{
+    return impl_name;
+}
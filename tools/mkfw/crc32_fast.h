@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 (reflected 0xEDB88320, pre- and post-inverted) as computed by
+// zlib's crc32() and the ESP32 ROM crc32_le(). The implementation is picked
+// once at startup: carry-less multiply folding on x86 with PCLMULQDQ, the
+// CRC32 instructions on ARMv8, otherwise a portable slice-by-16 table.
+uint32_t crc32_fast(uint32_t crc, const void* buf, size_t len);
+
+// CRC of A followed by B, given crc(A), crc(B) and the length of B
+uint32_t crc32_fast_combine(uint32_t crc1, uint32_t crc2, uint64_t len2);
+
+// Name of the selected implementation, for logs and benchmarks
+const char* crc32_fast_name();
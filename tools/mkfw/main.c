@@ -2,11 +2,17 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/stat.h>
 
-extern unsigned long crc32(unsigned long crc, const unsigned char* buf, unsigned int len);
+#include "crc32_fast.h"
 
 
-const char* FIRMWARE = "firmware.fw";
+const char* DEFAULT_OUTPUT = "firmware.fw";
 const char* HEADER = "ODROIDGO_FIRMWARE_V00_01";
 
 #define FIRMWARE_DESCRIPTION_SIZE (40)
@@ -32,126 +38,438 @@ typedef struct
 uint8_t tile[86 * 48 * 2];
 
 
-int main(int argc, char *argv[])
+// Partition data is split into chunks that worker threads read and
+// checksum in parallel. The main thread writes them in order and merges the
+// chunk CRCs with crc32_fast_combine. At most CHUNK_SLOTS_PER_JOB chunks per
+// worker are in memory, so memory use does not depend on the input sizes.
+#define CHUNK_SIZE (1024 * 1024)
+#define CHUNK_SLOTS_PER_JOB (2)
+#define JOBS_MAX (64)
+
+
+// The firmware is written to a temporary file next to the output and
+// renamed over it once complete. The checksum covers every byte written
+// and is updated as the bytes go out.
+typedef struct
+{
+    FILE* file;
+    char* path;
+    char* temp_path;
+    uint32_t checksum;
+    size_t length;
+} output_t;
+
+static output_t output;
+
+
+typedef struct
+{
+    odroid_partition_t part;
+    const char* filename;
+    int fd;
+    uint32_t length;
+    int first_chunk;
+    int chunk_count;
+} input_t;
+
+typedef struct
+{
+    int input;
+    off_t offset;
+    size_t length;
+} chunk_t;
+
+typedef struct
+{
+    uint8_t* data;
+    uint32_t crc;
+    int chunk;      // chunk held, -1 if free
+    bool ready;
+    bool failed;    // the read stopped at failed_offset
+    off_t failed_offset;
+} slot_t;
+
+static input_t* inputs;
+static int input_count;
+static chunk_t* chunks;
+static int chunk_count;
+
+static slot_t* slots;
+static int slot_count;
+static int next_chunk;      // next chunk a worker picks up
+static int written_chunks;  // chunks the writer has finished with
+static bool stopping;       // set by the main thread to end the workers early
+static pthread_t threads[JOBS_MAX];
+static int thread_count;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+
+static void workers_stop()
+{
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+
+    for (int t = 0; t < thread_count; ++t)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    thread_count = 0;
+}
+
+// Main thread only; workers report read errors through their slot
+static void fail(const char* message)
+{
+    printf("%s\n", message);
+
+    workers_stop();
+
+    if (output.file)
+    {
+        fclose(output.file);
+        remove(output.temp_path);
+    }
+
+    fflush(stdout);
+    abort();
+}
+
+static void output_open(const char* path)
+{
+    output.path = strdup(path);
+    output.temp_path = malloc(strlen(path) + 5);
+    if (!output.path || !output.temp_path) abort();
+
+    strcpy(output.temp_path, path);
+    strcat(output.temp_path, ".tmp");
+
+    output.file = fopen(output.temp_path, "wb");
+    if (!output.file)
+    {
+        printf("can not create '%s'.\n", output.temp_path);
+        abort();
+    }
+}
+
+static void output_write(const void* data, size_t length)
+{
+    if (fwrite(data, 1, length, output.file) != length) fail("write failed.");
+
+    output.checksum = crc32_fast(output.checksum, data, length);
+    output.length += length;
+}
+
+// Data whose CRC was already computed by a worker
+static void output_write_chunk(const void* data, size_t length, uint32_t crc)
 {
-    if (argc < 4)
+    if (fwrite(data, 1, length, output.file) != length) fail("write failed.");
+
+    output.checksum = crc32_fast_combine(output.checksum, crc, length);
+    output.length += length;
+}
+
+static void output_close()
+{
+    // The checksum itself is not part of the checksum
+    uint32_t checksum = output.checksum;
+    if (fwrite(&checksum, sizeof(checksum), 1, output.file) != 1) fail("write failed.");
+
+    printf("%s: checksum=%#010x\n", __func__, checksum);
+
+    if (fclose(output.file) != 0)
     {
-        printf("usage: %s description tile type subtype length label binary [...]\n", argv[0]);
+        output.file = NULL;
+        remove(output.temp_path);
+        printf("write failed.\n");
+        abort();
     }
-    else
+    output.file = NULL;
+
+    if (rename(output.temp_path, output.path) != 0)
     {
-        FILE* file = fopen(FIRMWARE, "wb");
-        if (!file) abort();
+        remove(output.temp_path);
+        printf("can not rename '%s' to '%s'.\n", output.temp_path, output.path);
+        abort();
+    }
 
-        size_t count;
+    printf("%s: wrote %ld bytes.\n", output.path, (long)(output.length + sizeof(checksum)));
+}
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void input_open(input_t* input)
+{
+    input->fd = open(input->filename, O_RDONLY);
+    if (input->fd < 0)
+    {
+        printf("'%s' not found.\n", input->filename);
+        fail("open failed.");
+    }
+
+    struct stat st;
+    if (fstat(input->fd, &st) != 0 || st.st_size < 0 || st.st_size > UINT32_MAX)
+        fail("invalid file size.");
 
-        count = fwrite(HEADER, strlen(HEADER), 1, file);
-        printf("HEADER='%s'\n", HEADER);
+    input->length = (uint32_t)st.st_size;
+    input->first_chunk = chunk_count;
+    input->chunk_count = (input->length + CHUNK_SIZE - 1) / CHUNK_SIZE;
 
+    chunks = realloc(chunks, sizeof(chunk_t) * (chunk_count + input->chunk_count));
+    if (!chunks) abort();
+
+    for (int i = 0; i < input->chunk_count; ++i)
+    {
+        chunk_t* chunk = &chunks[chunk_count++];
+        chunk->input = input - inputs;
+        chunk->offset = (off_t)i * CHUNK_SIZE;
+        chunk->length = input->length - (size_t)i * CHUNK_SIZE;
+        if (chunk->length > CHUNK_SIZE) chunk->length = CHUNK_SIZE;
+    }
+}
 
-        strncpy(FirmwareDescription, argv[1], FIRMWARE_DESCRIPTION_SIZE);
-        FirmwareDescription[FIRMWARE_DESCRIPTION_SIZE - 1] = 0;
+static void* worker(void* arg)
+{
+    (void)arg;
 
-        count = fwrite(FirmwareDescription, FIRMWARE_DESCRIPTION_SIZE, 1, file);
-        printf("FirmwareDescription='%s'\n", FirmwareDescription);
+    while (true)
+    {
+        pthread_mutex_lock(&lock);
 
-        FILE* tileFile = fopen(argv[2], "rb");
-        if (!tileFile)
+        // Chunk n uses slot n % slot_count once the writer is done with
+        // chunk n - slot_count
+        while (!stopping && next_chunk < chunk_count && next_chunk >= written_chunks + slot_count)
         {
-            printf("tile file not found.\n");
-            abort();
+            pthread_cond_wait(&changed, &lock);
         }
 
-        count = fread(tile, 1, sizeof(tile), tileFile);
-        if (count != sizeof(tile))
+        if (stopping || next_chunk >= chunk_count)
         {
-            printf("invalid tile file.\n");
-            abort();
+            pthread_mutex_unlock(&lock);
+            break;
         }
 
-        count = fwrite(tile, 1, sizeof(tile), file);
-        printf("tile: wrote %d bytes.\n", (int)count);
+        int index = next_chunk++;
+        slot_t* slot = &slots[index % slot_count];
+        slot->chunk = index;
+        slot->ready = false;
 
-        int part_count = 0;
-        int i = 3;
-        while (i < argc)
+        pthread_mutex_unlock(&lock);
+
+        const chunk_t* chunk = &chunks[index];
+        const input_t* input = &inputs[chunk->input];
+
+        size_t total = 0;
+        while (total < chunk->length)
         {
-            odroid_partition_t part = {0};
+            ssize_t count = pread(input->fd, slot->data + total, chunk->length - total, chunk->offset + total);
+            if (count <= 0) break;
 
+            total += count;
+        }
 
-            part.type = atoi(argv[i++]);
-            part.subtype = atoi(argv[i++]);
-            part.length = atoi(argv[i++]);
+        const bool failed = (total != chunk->length);
+        uint32_t crc = failed ? 0 : crc32_fast(0, slot->data, chunk->length);
 
-            const char* label = argv[i++];
-            strncpy(part.label, label, sizeof(part.label));
+        pthread_mutex_lock(&lock);
+        slot->crc = crc;
+        slot->failed = failed;
+        slot->failed_offset = chunk->offset + total;
+        slot->ready = true;
+        pthread_cond_broadcast(&changed);
+        pthread_mutex_unlock(&lock);
+    }
 
-            printf("[%d] type=%d, subtype=%d, length=%d, label=%-16s\n",
-                part_count, part.type, part.subtype, part.length, part.label);
+    return NULL;
+}
 
-            const char* filename = argv[i++];
+static void write_chunks(const input_t* input)
+{
+    for (int index = input->first_chunk; index < input->first_chunk + input->chunk_count; ++index)
+    {
+        slot_t* slot = &slots[index % slot_count];
 
-            FILE* binary = fopen(filename, "rb");
-            if (!binary) abort();
+        pthread_mutex_lock(&lock);
+        while (!(slot->chunk == index && slot->ready))
+        {
+            pthread_cond_wait(&changed, &lock);
+        }
+        pthread_mutex_unlock(&lock);
 
-            // get the file size
-            fseek(binary, 0, SEEK_END);
-            size_t fileSize = ftell(binary);
-            fseek(binary, 0, SEEK_SET);
+        if (slot->failed)
+        {
+            printf("read failed: '%s' at %ld\n", input->filename, (long)slot->failed_offset);
+            fail("read failed.");
+        }
 
-            // read the data
-            void* data = malloc(fileSize);
-            if (!data) abort();
+        output_write_chunk(slot->data, chunks[index].length, slot->crc);
 
-            count = fread(data, 1, fileSize, binary);
-            if (count != fileSize)
-            {
-                printf("fread failed: count=%ld, fileSize=%ld\n", count, fileSize);
-                abort();
-            }
+        pthread_mutex_lock(&lock);
+        slot->chunk = -1;
+        slot->ready = false;
+        ++written_chunks;
+        pthread_cond_broadcast(&changed);
+        pthread_mutex_unlock(&lock);
+    }
+}
 
-            fclose(binary);
 
-            // write the entry
-            fwrite(&part, sizeof(part), 1, file);
+int main(int argc, char *argv[])
+{
+    const char* outputPath = DEFAULT_OUTPUT;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
 
-            uint32_t length = (uint32_t)fileSize;
-            fwrite(&length, sizeof(length), 1, file);
+    int first = 1;
+    while (argc - first > 1)
+    {
+        if (strcmp(argv[first], "-o") == 0)
+        {
+            outputPath = argv[first + 1];
+        }
+        else if (strcmp(argv[first], "-j") == 0)
+        {
+            jobs = atol(argv[first + 1]);
+        }
+        else
+        {
+            break;
+        }
 
-            fwrite(data, fileSize, 1, file);
-            free(data);
+        first += 2;
+    }
 
-            printf("part=%d, length=%d, data=%s\n", part_count, length, filename);
+    if (jobs < 1) jobs = 1;
+    if (jobs > JOBS_MAX) jobs = JOBS_MAX;
 
-            part_count++;
-        }
+    if (argc - first < 3)
+    {
+        printf("usage: %s [-o output.fw] [-j jobs] description tile type subtype length label binary [...]\n", argv[0]);
+        return 1;
+    }
 
-        fclose(file);
+    double start = now_seconds();
 
-        // calculate checksum
-        file = fopen(FIRMWARE, "ab+");
-        if (!file) abort();
+    FILE* tileFile = fopen(argv[first + 1], "rb");
+    if (!tileFile)
+    {
+        printf("tile file not found.\n");
+        abort();
+    }
 
-        fseek(file, 0, SEEK_END);
-        size_t file_size = ftell(file);
-        fseek(file, 0, SEEK_SET);
+    size_t count = fread(tile, 1, sizeof(tile), tileFile);
+    fclose(tileFile);
 
-        const size_t BLOCK_SIZE = 4096;
+    if (count != sizeof(tile))
+    {
+        printf("invalid tile file.\n");
+        abort();
+    }
 
-        void* data = malloc(BLOCK_SIZE);
-        if (!data) abort();
+    // Partitions
+    if ((argc - first - 2) % 5 != 0)
+    {
+        printf("incomplete partition arguments.\n");
+        abort();
+    }
 
-        uint32_t checksum = 0;
-        for(int i = 0; i < (file_size); i += BLOCK_SIZE)
-        {
-            count = fread(data, 1, BLOCK_SIZE, file);
-            checksum = crc32(checksum, data, count);
-        }
+    input_count = (argc - first - 2) / 5;
+    inputs = calloc(input_count ? input_count : 1, sizeof(input_t));
+    if (!inputs) abort();
+
+    int i = first + 2;
+    for (int part_count = 0; part_count < input_count; ++part_count)
+    {
+        input_t* input = &inputs[part_count];
+        odroid_partition_t* part = &input->part;
+
+
+        part->type = atoi(argv[i++]);
+        part->subtype = atoi(argv[i++]);
+        part->length = atoi(argv[i++]);
+
+        const char* label = argv[i++];
+        strncpy((char*)part->label, label, sizeof(part->label));
+
+        input->filename = argv[i++];
+        input_open(input);
+    }
+
+    slot_count = (int)jobs * CHUNK_SLOTS_PER_JOB;
+    slots = calloc(slot_count, sizeof(slot_t));
+    if (!slots) abort();
+
+    for (int s = 0; s < slot_count; ++s)
+    {
+        slots[s].chunk = -1;
+        slots[s].data = malloc(CHUNK_SIZE);
+        if (!slots[s].data) abort();
+    }
+
+    output_open(outputPath);
+
+    for (int t = 0; t < jobs; ++t)
+    {
+        if (pthread_create(&threads[t], NULL, worker, NULL) != 0) fail("pthread_create failed.");
+        ++thread_count;
+    }
 
-        printf("%s: checksum=%#010x\n", __func__, checksum);
+    output_write(HEADER, strlen(HEADER));
+    printf("HEADER='%s'\n", HEADER);
 
-        fwrite(&checksum, sizeof(checksum), 1, file);
-        fclose(file);
+
+    strncpy(FirmwareDescription, argv[first], FIRMWARE_DESCRIPTION_SIZE);
+    FirmwareDescription[FIRMWARE_DESCRIPTION_SIZE - 1] = 0;
+
+    output_write(FirmwareDescription, FIRMWARE_DESCRIPTION_SIZE);
+    printf("FirmwareDescription='%s'\n", FirmwareDescription);
+
+    output_write(tile, sizeof(tile));
+    printf("tile: wrote %d bytes.\n", (int)sizeof(tile));
+
+    size_t payload = 0;
+    for (int part_count = 0; part_count < input_count; ++part_count)
+    {
+        const input_t* input = &inputs[part_count];
+        const odroid_partition_t* part = &input->part;
+
+        printf("[%d] type=%d, subtype=%d, length=%d, label=%-16s\n",
+            part_count, part->type, part->subtype, part->length, part->label);
+
+        // write the entry, the length, then the data
+        output_write(part, sizeof(*part));
+        output_write(&input->length, sizeof(input->length));
+        write_chunks(input);
+
+        printf("part=%d, length=%u, data=%s\n", part_count, input->length, input->filename);
+
+        payload += input->length;
+        close(input->fd);
+    }
+
+    // Every chunk is written, so the workers have already run out of work
+    workers_stop();
+
+    output_close();
+
+    double elapsed = now_seconds() - start;
+    if (elapsed <= 0) elapsed = 1e-9;
+
+    printf("%d partitions, %ld bytes in %.3f s (%.1f MB/s), %ld jobs, crc32 %s\n",
+        input_count, (long)payload, elapsed, payload / elapsed / (1024 * 1024), jobs, crc32_fast_name());
+
+    for (int s = 0; s < slot_count; ++s)
+    {
+        free(slots[s].data);
     }
+    free(slots);
+    free(chunks);
+    free(inputs);
 
+    return 0;
 }
@@ -0,0 +1,148 @@
+// Cross-checks every CRC32 implementation this machine can run against a
+// bitwise reference. Built with crc32_fast.c included so the paths that
+// were not picked at startup can be called directly. Run with: make check
+#include "crc32_fast.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+typedef struct
+{
+    const char* name;
+    crc32_impl_t function;
+} candidate_t;
+
+static candidate_t candidates[3];
+static int candidate_count;
+static int failures;
+
+static uint32_t crc32_reference(uint32_t crc, const uint8_t* buf, size_t len)
+{
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; ++k)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ POLY : crc >> 1;
+        }
+    }
+
+    return ~crc;
+}
+
+static void find_candidates()
+{
+    candidates[candidate_count++] = (candidate_t){ "slice-by-16", crc32_slice16 };
+
+#ifdef CRC32_FAST_X86
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1"))
+    {
+        candidates[candidate_count++] = (candidate_t){ "pclmulqdq", crc32_pclmul };
+    }
+#endif
+
+#ifdef CRC32_FAST_ARM
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+    {
+        candidates[candidate_count++] = (candidate_t){ "armv8-crc32", crc32_armv8 };
+    }
+#endif
+}
+
+static void expect(uint32_t actual, uint32_t expected, const char* what, const char* name,
+    size_t offset, size_t length)
+{
+    if (actual == expected) return;
+
+    if (++failures <= 20)
+    {
+        printf("%s: %s mismatch at offset %zu, length %zu: %08x != %08x\n",
+            name, what, offset, length, actual, expected);
+    }
+}
+
+// Every length up to a few folding blocks, at every alignment
+static void check_lengths(const uint8_t* data)
+{
+    for (int c = 0; c < candidate_count; ++c)
+    {
+        for (size_t offset = 0; offset < 16; ++offset)
+        {
+            for (size_t length = 0; length <= 520; ++length)
+            {
+                const uint32_t seed = (uint32_t)(length * 0x9e3779b9u);
+                uint32_t expected = crc32_reference(seed, data + offset, length);
+                uint32_t actual = ~candidates[c].function(~seed, data + offset, length);
+
+                expect(actual, expected, "crc", candidates[c].name, offset, length);
+            }
+        }
+    }
+}
+
+static void check_large(const uint8_t* data, size_t size)
+{
+    const size_t lengths[] = { 4096, 4096 + 13, 65536 - 1, 1 << 20, size - 3 };
+
+    for (int c = 0; c < candidate_count; ++c)
+    {
+        for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i)
+        {
+            uint32_t expected = crc32_reference(0, data + 3, lengths[i]);
+            uint32_t actual = ~candidates[c].function(~0u, data + 3, lengths[i]);
+
+            expect(actual, expected, "crc", candidates[c].name, 3, lengths[i]);
+        }
+    }
+}
+
+// Chained calls and crc32_fast_combine over split points around the
+// folding thresholds
+static void check_chaining(const uint8_t* data)
+{
+    const size_t total = 5000;
+    const size_t splits[] = { 0, 1, 15, 16, 17, 63, 64, 65, 127, 128, 1000, 4095, total };
+    const uint32_t whole = crc32_reference(0, data, total);
+
+    for (size_t i = 0; i < sizeof(splits) / sizeof(splits[0]); ++i)
+    {
+        const size_t split = splits[i];
+        const uint32_t first = crc32_fast(0, data, split);
+        const uint32_t second = crc32_fast(0, data + split, total - split);
+
+        expect(crc32_fast(first, data + split, total - split), whole, "chained", crc32_fast_name(), split, total);
+        expect(crc32_fast_combine(first, second, total - split), whole, "combine", "combine", split, total);
+    }
+}
+
+int main()
+{
+    const size_t size = (1 << 20) + 64;
+    uint8_t* data = malloc(size);
+    if (!data) return 1;
+
+    uint32_t state = 0x12345678;
+    for (size_t i = 0; i < size; ++i)
+    {
+        state = state * 1664525 + 1013904223;
+        data[i] = (uint8_t)(state >> 24);
+    }
+
+    find_candidates();
+
+    expect(crc32_fast(0, "123456789", 9), 0xcbf43926, "check value", crc32_fast_name(), 0, 9);
+    expect(crc32_fast(0x1234, NULL, 9), 0, "null buffer", crc32_fast_name(), 0, 9);
+
+    check_lengths(data);
+    check_large(data, size);
+    check_chaining(data);
+
+    printf("test_crc32: selected %s;", crc32_fast_name());
+    for (int c = 0; c < candidate_count; ++c) printf(" %s", candidates[c].name);
+    printf(" checked, %d failures\n", failures);
+
+    free(data);
+    return failures ? 1 : 0;
+}
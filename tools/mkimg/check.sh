@@ -0,0 +1,96 @@
+#!/bin/bash
+# Builds images from random inputs in both formats and checks that the
+# dense one matches the expected flash contents and that the sparse one
+# expands back to it. Run with: make check
+set -e
+
+MKIMG="$(pwd)/mkimg"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK"
+
+# Expected image from "offset file" pairs, and the sparse expansion of an
+# image. Exit status tells whether the two agree with the dense image.
+cat > verify.py <<'PY'
+import struct, sys
+
+dense, sparse = sys.argv[1], sys.argv[2]
+pairs = sys.argv[3:]
+
+extents = []
+for i in range(0, len(pairs), 2):
+    offset = int(pairs[i], 0)
+    with open(pairs[i + 1], "rb") as f:
+        extents.append((offset, f.read()))
+
+length = max([o + len(d) for o, d in extents] + [0])
+expected = bytearray(b"\xff" * length)
+for o, d in extents:
+    expected[o:o + len(d)] = d
+
+with open(dense, "rb") as f:
+    if f.read() != expected:
+        sys.exit("dense image differs from the expected contents")
+
+with open(sparse, "rb") as f:
+    data = f.read()
+
+magic, version, count, image_length = struct.unpack_from("<8sIII", data, 0)
+if magic != b"OGSPARSE" or version != 1 or count != len(extents) or image_length != length:
+    sys.exit("bad sparse header %r %d %d %d" % (magic, version, count, image_length))
+
+image = bytearray(b"\xff" * image_length)
+pos = 20
+last = 0
+for _ in range(count):
+    offset, size = struct.unpack_from("<II", data, pos)
+    pos += 8
+    if offset < last or offset + size > image_length:
+        sys.exit("sparse record out of order or range at %#x" % offset)
+    image[offset:offset + size] = data[pos:pos + size]
+    pos += size
+    last = offset + size
+
+if pos != len(data):
+    sys.exit("%d trailing bytes in the sparse image" % (len(data) - pos))
+if image != expected:
+    sys.exit("sparse image does not expand to the expected contents")
+PY
+
+# Checks one layout given as "offset size" pairs, listed in any order
+check()
+{
+    local args=()
+    local n=0
+    while [ $# -gt 0 ]; do
+        head -c "$2" /dev/urandom > "in$n.bin"
+        args+=("$1" "in$n.bin")
+        n=$((n + 1))
+        shift 2
+    done
+
+    "$MKIMG" dense.img "${args[@]}" > /dev/null
+    "$MKIMG" -s sparse.img "${args[@]}" > /dev/null
+    python3 verify.py dense.img sparse.img "${args[@]}"
+
+    echo "ok: ${args[*]}"
+    rm -f in*.bin dense.img sparse.img
+}
+
+# The layout pack.sh writes, out of order
+check 0x10000 1048576 0x1000 20000 0xf000 24 0x8000 3072
+# Adjacent extents from offset 0, decimal and hex offsets
+check 0 4096 4096 1 4097 65535 0x11000 7
+# An empty file, and an extent ending at the top of the flash
+check 0x1000 0 0x2000 100 16773120 4096
+# A single unaligned extent
+check 12345 54321
+
+# Overlapping extents are refused
+head -c 200 /dev/urandom > a.bin
+head -c 200 /dev/urandom > b.bin
+if { "$MKIMG" bad.img 0x1000 a.bin 0x1080 b.bin > /dev/null; } 2> /dev/null; then
+    echo "overlap accepted"
+    exit 1
+fi
+echo "ok: overlap refused"
@@ -4,74 +4,214 @@
 #include <stdint.h>
 
 
+// The image is written extent by extent in offset order, with erased flash
+// (0xff) streamed into the gaps, so memory use does not depend on the flash
+// size. With -s the gaps are left out entirely:
+//
+//   "OGSPARSE"  magic
+//   uint32      version (1)
+//   uint32      record count
+//   uint32      image length; anything not covered by a record is 0xff
+//   records:    uint32 offset, uint32 length, data[length]
+//
+// All values are little endian.
+
+#define FLASH_SIZE (16 * 1024 * 1024)
+#define COPY_BUFFER_SIZE (64 * 1024)
+#define ERASED (0xff)
+
+#define SPARSE_MAGIC "OGSPARSE"
+#define SPARSE_VERSION (1)
+
+
+typedef struct
+{
+    long offset;
+    long length;
+    const char* fileName;
+} extent_t;
+
+static uint8_t buffer[COPY_BUFFER_SIZE];
+
+
+static int extent_compare(const void* a, const void* b)
+{
+    const extent_t* x = (const extent_t*)a;
+    const extent_t* y = (const extent_t*)b;
+
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+static void write_data(FILE* outfile, const void* data, size_t length)
+{
+    if (fwrite(data, 1, length, outfile) != length)
+    {
+        printf("Write failed.\n");
+        abort();
+    }
+}
+
+static void write_u32(FILE* outfile, uint32_t value)
+{
+    uint8_t bytes[4] = { value, value >> 8, value >> 16, value >> 24 };
+    write_data(outfile, bytes, sizeof(bytes));
+}
+
+static void write_fill(FILE* outfile, long length)
+{
+    memset(buffer, ERASED, sizeof(buffer));
+
+    while (length > 0)
+    {
+        size_t count = length < sizeof(buffer) ? length : sizeof(buffer);
+        write_data(outfile, buffer, count);
+        length -= count;
+    }
+}
+
+static void copy_file(FILE* outfile, const extent_t* extent)
+{
+    FILE* file = fopen(extent->fileName, "rb");
+    if (!file) abort();
+
+    long remaining = extent->length;
+    while (remaining > 0)
+    {
+        size_t count = fread(buffer, 1, remaining < sizeof(buffer) ? remaining : sizeof(buffer), file);
+        if (count == 0)
+        {
+            printf("Read failed: '%s'.\n", extent->fileName);
+            abort();
+        }
+
+        write_data(outfile, buffer, count);
+        remaining -= count;
+    }
+
+    fclose(file);
+}
+
 
 int main(int argc, char *argv[])
 {
-    if (argc < 4)
+    int index = 1;
+    int sparse = 0;
+
+    if (index < argc && strcmp(argv[index], "-s") == 0)
     {
-        printf("usage: %s image_filename offset binary [...]\n", argv[0]);
+        sparse = 1;
+        ++index;
     }
-    else
+
+    if (argc - index < 3 || (argc - index - 1) % 2 != 0)
     {
-        const size_t imageLength = 16 * 1024 * 1024;
+        printf("usage: %s [-s] image_filename offset binary [...]\n", argv[0]);
+        return 1;
+    }
 
-        // Create image storage
-        uint8_t* imageData = (uint8_t*)malloc(imageLength);
-        if (!imageData) abort();
+    const char* outputFilename = argv[index++];
 
-        // Set image to 'erased'
-        memset(imageData, 0xff, imageLength);
+    const int extentCount = (argc - index) / 2;
+    extent_t* extents = (extent_t*)malloc(sizeof(extent_t) * extentCount);
+    if (!extents) abort();
 
+    long imageExtent = 0;
+    long payload = 0;
 
-        int index = 1;
-        long imageExtent = 0;
+    for (int i = 0; i < extentCount; ++i)
+    {
+        extent_t* extent = &extents[i];
 
-        const char* outputFilename = argv[index++];
+        int base = strncmp(argv[index], "0x", 2) == 0 ? 16 : 10;
 
-        while (index < argc)
+        char* end;
+        extent->offset = strtol(argv[index], &end, base);
+        if (*end || extent->offset < 0)
         {
-            int base = strncmp(argv[index], "0x", 2) == 0 ? 16 : 10;
+            printf("Invalid offset '%s'.\n", argv[index]);
+            abort();
+        }
+        ++index;
 
-            long offset = strtol(argv[index++], NULL, base);
-            const char* fileName = argv[index++];
+        extent->fileName = argv[index++];
 
-            // Open the file
-            FILE* file = fopen(fileName, "rb");
-            if (!file) abort();
+        // Open the file
+        FILE* file = fopen(extent->fileName, "rb");
+        if (!file) abort();
 
-            // get the file size
-            fseek(file, 0, SEEK_END);
-            size_t fileSize = ftell(file);
-            fseek(file, 0, SEEK_SET);
+        // get the file size
+        fseek(file, 0, SEEK_END);
+        extent->length = ftell(file);
+        fclose(file);
 
-            printf("offset=%ld, fileName='%s', fileSize=%ld\n", offset, fileName, fileSize);
+        printf("offset=%ld, fileName='%s', fileSize=%ld\n", extent->offset, extent->fileName, extent->length);
 
-            // Validate
-            long extent = offset + fileSize;
+        // Validate
+        long end_offset = extent->offset + extent->length;
 
-            if (extent > imageLength)
-            {
-                printf("Out of Range.\n");
-                abort();
-            }
+        if (extent->length < 0 || end_offset > FLASH_SIZE)
+        {
+            printf("Out of Range.\n");
+            abort();
+        }
 
-            if (extent > imageExtent) imageExtent = extent;
+        if (end_offset > imageExtent) imageExtent = end_offset;
+        payload += extent->length;
+    }
 
+    qsort(extents, extentCount, sizeof(extent_t), extent_compare);
 
-            // Read the data
-            fread(imageData + offset, 1, fileSize, file);
+    for (int i = 1; i < extentCount; ++i)
+    {
+        if (extents[i - 1].offset + extents[i - 1].length > extents[i].offset)
+        {
+            printf("'%s' overlaps '%s'.\n", extents[i - 1].fileName, extents[i].fileName);
+            abort();
+        }
+    }
 
-            // Close file
-            fclose(file);
+
+    // Write the image
+    FILE* outfile = fopen(outputFilename, "wb");
+    if (!outfile) abort();
+
+    if (sparse)
+    {
+        write_data(outfile, SPARSE_MAGIC, strlen(SPARSE_MAGIC));
+        write_u32(outfile, SPARSE_VERSION);
+        write_u32(outfile, extentCount);
+        write_u32(outfile, imageExtent);
+    }
+
+    long position = 0;
+    for (int i = 0; i < extentCount; ++i)
+    {
+        const extent_t* extent = &extents[i];
+
+        if (sparse)
+        {
+            write_u32(outfile, extent->offset);
+            write_u32(outfile, extent->length);
+        }
+        else
+        {
+            write_fill(outfile, extent->offset - position);
         }
 
-        // Write the image
-        FILE* outfile = fopen(outputFilename, "wb");
-        if (!outfile) abort();
+        copy_file(outfile, extent);
+        position = extent->offset + extent->length;
+    }
 
-        fwrite(imageData, 1, imageExtent, outfile);
-        fclose(outfile);
+    if (fclose(outfile) != 0)
+    {
+        printf("Write failed.\n");
+        abort();
     }
 
+    printf("%s: image length=%ld, payload=%ld, erased gaps=%ld%s\n", outputFilename,
+        imageExtent, payload, imageExtent - payload, sparse ? " (omitted)" : "");
+
+    free(extents);
+
     return 0;
 }